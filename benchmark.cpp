@@ -0,0 +1,832 @@
+#include "bezier.h"
+#include "bezier_bake.h"
+#include "bezier_quantized.h"
+#include "bezier_compact.h"
+#include "bezier_static.h"
+#include "bezier_scalar.h"
+#include "bezier_easing.h"
+#include "bezier_power.h"
+#include "bezier_svg.h"
+#include "bezier_raster.h"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * Micro benchmarks do bz. Cada benchmark mede ns por avaliação e o erro máximo
+ * contra a avaliação direta (bz::animation_update).
+ *
+ * Uso: BezierBenchmark [nome] [--bullets N] [--frames F]
+ * Sem nome roda todos. Compile em Release para números que signifiquem algo.
+*/
+
+
+typedef struct bench_options {
+    int bullets = 10000;
+    int frames = 600;
+    float dt = 1.f / 60.f;
+} bench_options_t;
+
+
+std::default_random_engine generator(42);
+
+
+/**
+ * Cria count animações de grau degree com pontos aleatórios na tela
+*/
+std::vector<bz::bezier_animation_t> make_animations(const int count, const int degree, const bool loop) {
+    std::uniform_real_distribution<float> coord(0.f, 800.f);
+    std::uniform_real_distribution<float> duration(2.f, 6.f);
+    std::vector<bz::bezier_animation_t> animations;
+    animations.reserve(count);
+    for (int i = 0; i < count; i++) {
+        bz::bezier_animation_t a({coord(generator), coord(generator)}, {coord(generator), coord(generator)});
+        for (int k = 1; k < degree; k++) {
+            bz::push_back_control_point(&a, {coord(generator), coord(generator)});
+        }
+        a.time_to_complete = duration(generator);
+        a.loop = loop;
+        animations.push_back(std::move(a));
+    }
+    return animations;
+}
+
+
+/**
+ * Roda fn em todos os frames e retorna ns por animação por frame
+*/
+template<typename Fn>
+double time_frames(const bench_options_t& options, Fn fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < options.frames; f++) {
+        fn(f);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / ((double) options.frames * options.bullets);
+}
+
+
+void print_result(const char* name, const double ns, const double error) {
+    std::printf("%-36s %10.2f ns/op   erro máx %.3g\n", name, ns, error);
+}
+
+
+/**
+ * Direto vs forward differencing (animation_update_stepped), com dt constante.
+ * Fora dos graus 4 e 5 o stepped cai na avaliação direta.
+*/
+void bench_stepper(const bench_options_t& options) {
+    for (const int degree : {1, 3, 4, 5, 7}) {
+        std::vector<bz::bezier_animation_t> direct = make_animations(options.bullets, degree, true);
+        std::vector<bz::bezier_animation_t> stepped = direct;
+        std::vector<bz::forward_stepper_t> steppers(stepped.size()); // Tabela paralela às animações
+        const double direct_ns = time_frames(options, [&](int) {
+            for (bz::bezier_animation_t& a : direct) {
+                bz::animation_update(&a, options.dt);
+            }
+        });
+        const double stepped_ns = time_frames(options, [&](int) {
+            for (std::size_t i = 0; i < stepped.size(); i++) {
+                bz::animation_update_stepped(&stepped[i], &steppers[i], options.dt);
+            }
+        });
+        double error = 0.0;
+        for (int i = 0; i < options.bullets; i++) {
+            error = std::max(error, (double) std::fabs(direct[i].C.x - stepped[i].C.x));
+            error = std::max(error, (double) std::fabs(direct[i].C.y - stepped[i].C.y));
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "direct grau %d", degree);
+        print_result(name, direct_ns, 0.0);
+        std::snprintf(name, sizeof(name), "stepped grau %d", degree);
+        print_result(name, stepped_ns, error);
+    }
+}
+
+
+#define BENCH_TEMPLATE_WAVE 16 // Bullets por onda (mesmo t) no lote de modelos
+
+/**
+ * Direto vs caminho pré-amostrado, linear e cúbico, com easing. O último caso
+ * é o do jogo: um caminho (bake_template) compartilhado por todos os bullets.
+*/
+void bench_bake(const bench_options_t& options) {
+    const bz::TBasicFunction easings[] = {bz::TBasicFunction::Normal, bz::TBasicFunction::Parabola};
+    const char* easing_names[] = {"Normal", "Parabola"};
+    for (int e = 0; e < 2; e++) {
+        std::vector<bz::bezier_animation_t> direct = make_animations(options.bullets, 3, true);
+        for (bz::bezier_animation_t& a : direct) {
+            a.t_function = easings[e];
+        }
+        const bz::TInterpolation modes[] = {bz::TInterpolation::LinearInterpolation, bz::TInterpolation::CubicInterpolation};
+        for (const bz::TInterpolation mode : modes) {
+            std::vector<bz::bezier_animation_t> reference = direct;
+            bz::bake_library_t library;
+            std::vector<bz::baked_animation_t> baked(options.bullets);
+            std::size_t samples = 0;
+            for (int i = 0; i < options.bullets; i++) {
+                const bz::bezier_animation_t& a = reference[i];
+                baked[i].path_id = bz::add_baked_path(
+                    &library, a.control_points.data(), a.control_points.size(), a.t_function, mode
+                );
+                baked[i].time_to_complete = a.time_to_complete;
+                baked[i].loop = a.loop;
+                samples += library.paths.back().samples.size();
+            }
+            const double direct_ns = time_frames(options, [&](int) {
+                for (bz::bezier_animation_t& a : reference) {
+                    bz::animation_update(&a, options.dt);
+                }
+            });
+            const double baked_ns = time_frames(options, [&](int) {
+                for (bz::baked_animation_t& a : baked) {
+                    bz::animation_update(&library, &a, options.dt);
+                }
+            });
+            double error = 0.0;
+            for (int i = 0; i < options.bullets; i++) {
+                // No frame em que o loop volta a animação direta extrapola a curva e a tabela não
+                if (reference[i].t >= 0.0 && reference[i].t <= 1.0) {
+                    error = std::max(error, (double) Vector2Distance(reference[i].C, baked[i].C));
+                }
+            }
+            char name[64];
+            std::snprintf(name, sizeof(name), "direct %s", easing_names[e]);
+            print_result(name, direct_ns, 0.0);
+            std::snprintf(
+                name, sizeof(name), "baked %s %s (%zu amostras)", mode == bz::TInterpolation::LinearInterpolation ? "linear" : "cúbico",
+                easing_names[e], samples / options.bullets
+            );
+            print_result(name, baked_ns, error);
+        }
+    }
+
+    // Tabela compartilhada: um bake_template usado por todos os bullets, cada um com a sua transformação
+    const std::vector<bz::bezier_animation_t> shape = make_animations(1, 3, true);
+    std::uniform_real_distribution<float> offset(-200.f, 200.f);
+    std::uniform_real_distribution<float> duration(2.f, 6.f);
+    bz::template_library_t templates;
+    const int template_id = bz::add_template(
+        &templates, {shape[0].control_points.begin(), shape[0].control_points.end()}
+    );
+    bz::bake_library_t library;
+    const int path_id = bz::bake_template(&library, templates, template_id, bz::TBasicFunction::Parabola);
+    std::vector<bz::template_animation_t> direct(options.bullets);
+    std::vector<bz::baked_animation_t> baked(options.bullets);
+    std::vector<bz::bezier_animation_t> own; // Cada bullet com a sua cópia dos pontos (kernels de evaluate_curve)
+    own.reserve(options.bullets);
+    for (int i = 0; i < options.bullets; i++) {
+        direct[i].template_id = template_id;
+        direct[i].transform = bz::make_transform({1.f, 1.f}, {offset(generator), offset(generator)});
+        direct[i].time_to_complete = duration(generator);
+        direct[i].t_function = bz::TBasicFunction::Parabola;
+        direct[i].loop = true;
+        baked[i].path_id = path_id;
+        baked[i].transform = direct[i].transform;
+        baked[i].time_to_complete = direct[i].time_to_complete;
+        baked[i].loop = true;
+        bz::bezier_animation_t a = shape[0];
+        for (Vector2& p : a.control_points) {
+            p = bz::transform_point(direct[i].transform, p);
+        }
+        bz::control_points_changed(&a);
+        a.time_to_complete = direct[i].time_to_complete;
+        a.t_function = bz::TBasicFunction::Parabola;
+        own.push_back(std::move(a));
+    }
+    const double own_ns = time_frames(options, [&](int) {
+        for (bz::bezier_animation_t& a : own) {
+            bz::animation_update(&a, options.dt);
+        }
+    });
+    const double direct_ns = time_frames(options, [&](int) {
+        for (bz::template_animation_t& a : direct) {
+            bz::animation_update(&templates, &a, options.dt);
+        }
+    });
+    // Em ondas: BENCH_TEMPLATE_WAVE bullets com a mesma duração, espalhadas pelo vetor
+    std::vector<bz::template_animation_t> waves = direct;
+    for (int i = 0; i < options.bullets; i++) {
+        waves[i].time_to_complete = direct[i % (options.bullets / BENCH_TEMPLATE_WAVE + 1)].time_to_complete;
+        waves[i].time_count = 0.0;
+    }
+    std::vector<bz::template_animation_t> waves_reference = waves;
+    const double batch_ns = time_frames(options, [&](int) {
+        bz::animation_update(&templates, waves.data(), waves.size(), options.dt);
+    });
+    time_frames(options, [&](int) {
+        for (bz::template_animation_t& a : waves_reference) {
+            bz::animation_update(&templates, &a, options.dt);
+        }
+    });
+    double batch_error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        batch_error = std::max(batch_error, (double) Vector2Distance(waves[i].C, waves_reference[i].C));
+    }
+    const double baked_ns = time_frames(options, [&](int) {
+        for (bz::baked_animation_t& a : baked) {
+            bz::animation_update(&library, &a, options.dt);
+        }
+    });
+    double error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        if (direct[i].t >= 0.0 && direct[i].t <= 1.0) {
+            error = std::max(error, (double) Vector2Distance(direct[i].C, baked[i].C));
+        }
+    }
+    print_result("direct pontos próprios Parabola", own_ns, 0.0);
+    print_result("direct modelo Parabola", direct_ns, 0.0);
+    print_result("direct modelo em ondas (lote)", batch_ns, batch_error);
+    char name[64];
+    std::snprintf(
+        name, sizeof(name), "baked compartilhado (%zu amostras)", library.paths[path_id].samples.size()
+    );
+    print_result(name, baked_ns, error);
+}
+
+
+/**
+ * Caminho amostrado em float vs quantizado em 16 bits (um caminho por bullet)
+*/
+void bench_quantized(const bench_options_t& options) {
+    std::vector<bz::bezier_animation_t> reference = make_animations(options.bullets, 3, false);
+    bz::bake_library_t baked_library;
+    bz::quantized_library_t quantized_library;
+    std::vector<bz::baked_animation_t> baked(options.bullets);
+    std::vector<bz::quantized_animation_t> quantized(options.bullets);
+    for (int i = 0; i < options.bullets; i++) {
+        const bz::bezier_animation_t& a = reference[i];
+        baked[i].path_id = bz::add_baked_path(
+            &baked_library, a.control_points.data(), a.control_points.size(), a.t_function,
+            bz::TInterpolation::LinearInterpolation
+        );
+        quantized[i].path_id = bz::add_quantized_path(&quantized_library, baked_library.paths.back());
+        baked[i].time_to_complete = quantized[i].time_to_complete = a.time_to_complete;
+    }
+    std::size_t float_bytes = 0;
+    for (const bz::baked_path_t& path : baked_library.paths) {
+        float_bytes += path.samples.size() * sizeof(Vector2);
+    }
+    const std::size_t quantized_bytes = quantized_library.data.size() * sizeof(std::uint16_t) +
+        quantized_library.paths.size() * sizeof(bz::quantized_path_t);
+    const double baked_ns = time_frames(options, [&](int) {
+        for (bz::baked_animation_t& a : baked) {
+            bz::animation_update(&baked_library, &a, options.dt);
+        }
+    });
+    const double quantized_ns = time_frames(options, [&](int) {
+        for (bz::quantized_animation_t& a : quantized) {
+            bz::animation_update(&quantized_library, &a, options.dt);
+        }
+    });
+    double error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        error = std::max(error, (double) Vector2Distance(baked[i].C, quantized[i].C));
+    }
+    print_result("baked float", baked_ns, 0.0);
+    print_result("quantized 16 bits", quantized_ns, error);
+    std::printf("memória: float %zu KiB, quantizado %zu KiB\n", float_bytes / 1024, quantized_bytes / 1024);
+
+    // Decodificação em bloco de todas as amostras
+    std::vector<Vector2> decoded;
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t samples = 0;
+    for (std::size_t p = 0; p < quantized_library.paths.size(); p++) {
+        const int count = quantized_library.paths[p].count;
+        decoded.resize(count);
+        bz::decode_quantized_path(quantized_library, p, 0, count, decoded.data());
+        samples += count;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-36s %10.2f ns/amostra\n", "decode em bloco", ns / samples);
+}
+
+
+/**
+ * bezier_animation_t vs compact_bullet_t (32 bytes) com as mesmas curvas.
+ * Os modelos são compartilhados por BENCH_COMPACT_SHARING bullets, cada um
+ * com a sua translação. O compacto só é aceito se a varredura for mais rápida.
+*/
+#define BENCH_COMPACT_SHARING 16
+
+void bench_compact(const bench_options_t& options) {
+    std::vector<bz::bezier_animation_t> reference = make_animations(options.bullets, 3, true);
+    std::uniform_real_distribution<float> offset(-200.f, 200.f);
+    bz::template_library_t library;
+    std::vector<bz::compact_bullet_t> compact;
+    compact.reserve(options.bullets);
+    int id = -1;
+    for (int i = 0; i < options.bullets; i++) {
+        bz::bezier_animation_t& a = reference[i];
+        if (i % BENCH_COMPACT_SHARING == 0) {
+            id = bz::add_template(&library, {a.control_points.begin(), a.control_points.end()});
+        }
+        const Vector2 translation = {offset(generator), offset(generator)};
+        const std::vector<Vector2>& model = library.templates[id].control_points;
+        for (std::size_t k = 0; k < model.size(); k++) {
+            a.control_points[k] = Vector2Add(model[k], translation);
+        }
+        bz::control_points_changed(&a);
+        compact.push_back(bz::to_compact(a, id, translation));
+    }
+    const double direct_ns = time_frames(options, [&](int) {
+        for (bz::bezier_animation_t& a : reference) {
+            bz::animation_update(&a, options.dt);
+        }
+    });
+    const double compact_ns = time_frames(options, [&](int) {
+        bz::animation_update(&library, compact.data(), compact.size(), options.dt);
+    });
+    double error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        // Com tempo em float o loop pode voltar um frame antes ou depois
+        const bool reverse = (compact[i].flags & BZ_COMPACT_REVERSE) != 0;
+        if (reference[i].t >= 0.0 && reference[i].t <= 1.0 && reference[i].reverse == reverse) {
+            error = std::max(error, (double) Vector2Distance(reference[i].C, compact[i].C));
+        }
+    }
+    char name[64];
+    std::snprintf(name, sizeof(name), "bezier_animation_t (%zu B)", sizeof(bz::bezier_animation_t));
+    print_result(name, direct_ns, 0.0);
+    std::snprintf(name, sizeof(name), "compact_bullet_t (%zu B)", sizeof(bz::compact_bullet_t));
+    print_result(name, compact_ns, error);
+    std::printf(
+        "varredura: %.3f ms/frame direto, %.3f ms/frame compacto (%s)\n",
+        direct_ns * options.bullets / 1e6, compact_ns * options.bullets / 1e6,
+        compact_ns < direct_ns ? "aceito" : "REJEITADO: mais lento que o direto"
+    );
+}
+
+
+/**
+ * Laço genérico vs kernel especializado (animation_update) por grau
+*/
+void bench_dispatch(const bench_options_t& options) {
+    for (int degree = 1; degree <= 4; degree++) {
+        std::vector<bz::bezier_animation_t> generic = make_animations(options.bullets, degree, false);
+        std::vector<bz::bezier_animation_t> dispatched = generic;
+        const double generic_ns = time_frames(options, [&](int) {
+            for (bz::bezier_animation_t& a : generic) {
+                const double t = bz::update_progress(&a, options.dt);
+                a.C = bz::evaluate_generic(a.control_points.data(), a.control_points.size(), t);
+            }
+        });
+        const double dispatched_ns = time_frames(options, [&](int) {
+            for (bz::bezier_animation_t& a : dispatched) {
+                bz::animation_update(&a, options.dt);
+            }
+        });
+        double error = 0.0;
+        for (int i = 0; i < options.bullets; i++) {
+            error = std::max(error, (double) Vector2Distance(generic[i].C, dispatched[i].C));
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "genérico grau %d", degree);
+        print_result(name, generic_ns, 0.0);
+        std::snprintf(name, sizeof(name), "%s grau %d", degree <= 3 ? "especializado" : "dispatch", degree);
+        print_result(name, dispatched_ns, error);
+    }
+}
+
+
+// Caminho conhecido no build: a tabela é montada pelo compilador
+constexpr bz::bezier<3> static_curve = bz::make_bezier(
+    Vector2{0.f, 0.f}, Vector2{200.f, 600.f}, Vector2{600.f, -200.f}, Vector2{800.f, 400.f}
+);
+constexpr std::array<Vector2, 33> static_table = bz::bake_static<33>(static_curve);
+static_assert(static_table[0].x == 0.f && static_table[32].x == 800.f, "bake_static em constexpr");
+
+/**
+ * Cúbica dinâmica (animation_update) vs bz::bezier<3> embrulhada e direta
+*/
+void bench_static(const bench_options_t& options) {
+    std::vector<bz::bezier_animation_t> dynamic = make_animations(options.bullets, 1, false);
+    for (bz::bezier_animation_t& a : dynamic) {
+        a.control_points.assign(
+            {{0.f, 0.f}, {200.f, 600.f}, {600.f, -200.f}, {800.f, 400.f}}
+        );
+    }
+    std::vector<bz::bezier_animation_t> wrapped = dynamic;
+    for (bz::bezier_animation_t& a : wrapped) {
+        bz::wrap(&a, &static_curve);
+    }
+    std::vector<bz::animation_state_t> states(dynamic.begin(), dynamic.end());
+    const double dynamic_ns = time_frames(options, [&](int) {
+        for (bz::bezier_animation_t& a : dynamic) {
+            bz::animation_update(&a, options.dt);
+        }
+    });
+    const double wrapped_ns = time_frames(options, [&](int) {
+        for (bz::bezier_animation_t& a : wrapped) {
+            bz::animation_update(&a, options.dt);
+        }
+    });
+    const double direct_ns = time_frames(options, [&](int) {
+        for (bz::animation_state_t& a : states) {
+            const bz::point<float> p = bz::evaluate(static_curve, (float) bz::update_progress(&a, options.dt));
+            a.C = {p.x, p.y};
+        }
+    });
+    double wrapped_error = 0.0, direct_error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        wrapped_error = std::max(wrapped_error, (double) Vector2Distance(dynamic[i].C, wrapped[i].C));
+        direct_error = std::max(direct_error, (double) Vector2Distance(dynamic[i].C, states[i].C));
+    }
+    print_result("dinâmica grau 3", dynamic_ns, 0.0);
+    print_result("bz::bezier<3> via wrap", wrapped_ns, wrapped_error);
+    print_result("bz::bezier<3> direta", direct_ns, direct_error);
+}
+
+
+constexpr bz::bezier<3, bz::fixed16_t> fixed_curve = bz::make_bezier<bz::fixed16_t>(
+    Vector2{0.f, 0.f}, Vector2{200.f, 600.f}, Vector2{600.f, -200.f}, Vector2{800.f, 400.f}
+);
+static_assert(bz::evaluate(fixed_curve, bz::fixed16_t(1)).x == bz::fixed16_t(800), "fixed16 em constexpr");
+
+#define BENCH_SCALAR_SAMPLES 64
+
+/**
+ * O erro é medido com os dois avaliadores no mesmo t; a diferença de posição
+ * depois dos frames (tempo acumulado em Scalar) sai à parte, como deriva
+*/
+template<typename Scalar>
+void bench_scalar_type(
+    const bench_options_t& options,
+    const char* name,
+    const std::vector<bz::bezier_animation_t>& source,
+    const std::vector<bz::bezier_animation_t>& reference
+) {
+    std::vector<bz::basic_animation<Scalar>> animations;
+    animations.reserve(source.size());
+    for (const bz::bezier_animation_t& a : source) {
+        animations.push_back(bz::to_scalar<Scalar>(a));
+    }
+    const Scalar dt = Scalar(options.dt);
+    if constexpr (std::is_floating_point_v<Scalar>) {
+        // Lote SoA com as mesmas animações: mesmo relógio, então a diferença é só de arredondamento
+        bz::animation_batch<Scalar> batch;
+        bz::to_batch(animations.data(), animations.size(), &batch);
+        bz::batch_scratch<Scalar> scratch;
+        std::vector<bz::basic_animation<Scalar>> check = animations;
+        const double batch_ns = time_frames(options, [&](int) {
+            bz::animation_update(&batch, dt, &scratch);
+        });
+        time_frames(options, [&](int) {
+            bz::animation_update(check.data(), check.size(), dt);
+        });
+        double batch_error = 0.0;
+        for (std::size_t i = 0; i < check.size(); i++) {
+            batch_error = std::max(batch_error, (double) Vector2Distance(
+                bz::to_vector2(check[i].C), bz::to_vector2(bz::batch_point(batch, i))
+            ));
+        }
+        char batch_name[64];
+        std::snprintf(batch_name, sizeof(batch_name), "%s SoA", name);
+        print_result(batch_name, batch_ns, batch_error);
+    }
+    const double ns = time_frames(options, [&](int) {
+        bz::animation_update(animations.data(), animations.size(), dt);
+    });
+    // Erro do avaliador: as duas curvas no mesmo t
+    double error = 0.0;
+    for (std::size_t i = 0; i < animations.size(); i++) {
+        const bz::bezier_animation_t& a = source[i];
+        for (int s = 0; s <= BENCH_SCALAR_SAMPLES; s++) {
+            const double t = (double) s / BENCH_SCALAR_SAMPLES;
+            const Vector2 expected = bz::evaluate_curve(a.control_points.data(), a.control_points.size(), t);
+            const bz::point<Scalar> got = bz::evaluate_curve(
+                animations[i].control_points.data(), animations[i].control_points.size(), Scalar(t)
+            );
+            error = std::max(error, (double) Vector2Distance(expected, bz::to_vector2(got)));
+        }
+    }
+    print_result(name, ns, error);
+    // Deriva do tempo: o relógio em Scalar se afasta do relógio em double
+    double drift_t = 0.0;
+    double drift_px = 0.0;
+    for (std::size_t i = 0; i < animations.size(); i++) {
+        if (reference[i].reverse == animations[i].reverse) {
+            drift_t = std::max(drift_t, std::fabs(reference[i].t - (double) animations[i].t));
+            drift_px = std::max(drift_px, (double) Vector2Distance(reference[i].C, bz::to_vector2(animations[i].C)));
+        }
+    }
+    std::printf("%-36s deriva do tempo: t %.3g, posição %.3g px\n", "", drift_t, drift_px);
+}
+
+/**
+ * float vs double vs ponto fixo 16.16, erro contra evaluate_curve
+*/
+void bench_scalar(const bench_options_t& options) {
+    for (int degree = 3; degree <= 7; degree += 4) {
+        const std::vector<bz::bezier_animation_t> source = make_animations(options.bullets, degree, true);
+        std::vector<bz::bezier_animation_t> reference = source;
+        const double reference_ns = time_frames(options, [&](int) {
+            for (bz::bezier_animation_t& a : reference) {
+                bz::animation_update(&a, options.dt);
+            }
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "animation_update grau %d", degree);
+        print_result(name, reference_ns, 0.0);
+        std::snprintf(name, sizeof(name), "float grau %d", degree);
+        bench_scalar_type<float>(options, name, source, reference);
+        std::snprintf(name, sizeof(name), "double grau %d", degree);
+        bench_scalar_type<double>(options, name, source, reference);
+        std::snprintf(name, sizeof(name), "fixed16 grau %d", degree);
+        bench_scalar_type<bz::fixed16_t>(options, name, source, reference);
+    }
+}
+
+
+/**
+ * Easing por bullet (switch em animation_update) vs agrupado em lote, e a
+ * precisão das aproximações e do cubic-bezier
+*/
+void bench_easing(const bench_options_t& options) {
+    std::uniform_int_distribution<int> easing(0, BZ_EASING_BUILTIN_COUNT - 1);
+    std::vector<bz::bezier_animation_t> reference = make_animations(options.bullets, 3, false);
+    for (bz::bezier_animation_t& a : reference) {
+        a.t_function = (bz::TBasicFunction) easing(generator);
+        a.time_to_complete = 1e6; // Sem loop nem fim: só o custo do easing e da curva
+    }
+    std::vector<bz::bezier_animation_t> batched = reference;
+    bz::easing_library_t library;
+    bz::easing_scratch_t scratch;
+    const double reference_ns = time_frames(options, [&](int) {
+        for (bz::bezier_animation_t& a : reference) {
+            bz::animation_update(&a, options.dt);
+        }
+    });
+    const double batched_ns = time_frames(options, [&](int) {
+        bz::animation_update_eased(library, batched.data(), batched.size(), options.dt, &scratch);
+    });
+    double error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        error = std::max(error, (double) Vector2Distance(reference[i].C, batched[i].C));
+    }
+    print_result("easing por bullet", reference_ns, 0.0);
+    print_result("easing em lote", batched_ns, error);
+
+    // cubic-bezier(.25, .1, .25, 1) ("ease" do CSS) contra bissecção em double
+    const int ease = bz::add_cubic_bezier(&library, 0.25f, 0.1f, 0.25f, 1.f);
+    const bz::cubic_bezier_timing_t& c = library.cubic_beziers[ease - BZ_EASING_BUILTIN_COUNT];
+    std::vector<float> x(options.bullets), y(options.bullets);
+    for (int i = 0; i < options.bullets; i++) {
+        x[i] = (float) i / (options.bullets - 1);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < options.frames; f++) {
+        bz::ease_batch(library, ease, x.data(), y.data(), x.size());
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double bezier_error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        double lo = 0.0, hi = 1.0;
+        for (int k = 0; k < 60; k++) {
+            const double s = 0.5 * (lo + hi);
+            ((((double) c.ax * s + c.bx) * s + c.cx) * s < x[i] ? lo : hi) = s;
+        }
+        const double s = 0.5 * (lo + hi);
+        bezier_error = std::max(bezier_error, std::fabs((((double) c.ay * s + c.by) * s + c.cy) * s - y[i]));
+    }
+    print_result("cubic-bezier(.25,.1,.25,1)", ns / ((double) options.frames * options.bullets), bezier_error);
+
+    double sqrt_error = 0.0, pow_error = 0.0;
+    for (int i = 0; i < options.bullets; i++) {
+        const float v = (float) (i + 1) / options.bullets;
+        sqrt_error = std::max(sqrt_error, (double) std::fabs(bz::fast_sqrt(v) - std::sqrt(v)));
+        pow_error = std::max(pow_error, std::fabs(bz::fast_pow(v, 2.5f) - std::pow((double) v, 2.5)));
+    }
+    std::printf("fast_sqrt erro máx %.3g, fast_pow(x, 2.5) erro máx %.3g em (0, 1]\n", sqrt_error, pow_error);
+}
+
+
+/**
+ * Curva compilada + easing separado vs B(e(t)) composto em um polinômio, por
+ * grau da curva, com um easing por vez e com os easings misturados (onde o
+ * switch de apply_t_function erra a previsão). Só os misturados ganham com a
+ * composição, por isso ela é opcional em bz::compile_animation.
+*/
+void bench_compose(const bench_options_t& options) {
+    const bz::TBasicFunction easings[] = {
+        bz::TBasicFunction::Quadratic, bz::TBasicFunction::Cubic,
+        bz::TBasicFunction::QuadraticEasyOut, bz::TBasicFunction::Parabola
+    };
+    const char* easing_names[] = {"Quadratic", "Cubic", "QuadraticEasyOut", "Parabola", "misturados"};
+    std::uniform_int_distribution<int> random_easing(0, 3);
+    for (int degree = 1; degree <= 3; degree++) {
+        for (int e = 0; e <= 4; e++) {
+            const std::vector<bz::bezier_animation_t> source = make_animations(options.bullets, degree, true);
+            std::vector<bz::compiled_animation_t> separate(options.bullets), composed(options.bullets);
+            int count = 0;
+            for (int i = 0; i < options.bullets; i++) {
+                const bz::bezier_animation_t& a = source[i];
+                const bz::TBasicFunction f = easings[e < 4 ? e : random_easing(generator)];
+                static_cast<bz::animation_state_t&>(separate[i]) = a;
+                separate[i].t_function = f;
+                composed[i] = separate[i];
+                bz::compile_power_curve(a.control_points.data(), a.control_points.size(), &separate[i].curve);
+                if (bz::compose_power_curve(a.control_points.data(), a.control_points.size(), f, &composed[i].curve)) {
+                    composed[i].t_function = bz::TBasicFunction::Normal;
+                    count++;
+                } else {
+                    composed[i].curve = separate[i].curve;
+                }
+            }
+            if (count == 0) {
+                std::printf("grau %d %-16s composição passa do grau ou da tolerância\n", degree, easing_names[e]);
+                continue;
+            }
+            const double separate_ns = time_frames(options, [&](int) {
+                for (bz::compiled_animation_t& a : separate) {
+                    bz::animation_update(&a, options.dt);
+                }
+            });
+            const double composed_ns = time_frames(options, [&](int) {
+                for (bz::compiled_animation_t& a : composed) {
+                    bz::animation_update(&a, options.dt);
+                }
+            });
+            double error = 0.0;
+            for (int i = 0; i < options.bullets; i++) {
+                if (separate[i].reverse == composed[i].reverse) {
+                    error = std::max(error, (double) Vector2Distance(separate[i].C, composed[i].C));
+                }
+            }
+            char name[64];
+            std::snprintf(name, sizeof(name), "grau %d %s separado", degree, easing_names[e]);
+            print_result(name, separate_ns, 0.0);
+            std::snprintf(name, sizeof(name), "grau %d %s composto", degree, easing_names[e]);
+            print_result(name, composed_ns, error);
+        }
+    }
+}
+
+
+/**
+ * Importação de SVG: parse + amostragem de bullets / 10 caminhos com 4 a 12
+ * segmentos cada, com 1 thread e com todas. Aqui o tempo é por caminho.
+*/
+void bench_svg(const bench_options_t& options) {
+    const int count = std::max(1, options.bullets / 10);
+    // Passeio aleatório com juntas suaves (S), como um caminho desenhado à mão
+    std::uniform_real_distribution<float> coord(0.f, 800.f);
+    std::uniform_real_distribution<float> step(-120.f, 120.f);
+    std::uniform_int_distribution<int> segments(4, 12);
+    std::string text = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"800\" height=\"800\">\n";
+    char buffer[64];
+    for (int i = 0; i < count; i++) {
+        float x = coord(generator), y = coord(generator);
+        std::snprintf(buffer, sizeof(buffer), "<path d=\"M %.1f %.1f C", x, y);
+        text += buffer;
+        for (int s = 0; s < segments(generator); s++) {
+            for (int k = s == 0 ? 0 : 1; k < 3; k++) {
+                x += step(generator);
+                y += step(generator);
+                std::snprintf(buffer, sizeof(buffer), " %s%.1f %.1f", s > 0 && k == 1 ? "S " : "", x, y);
+                text += buffer;
+            }
+        }
+        text += "\"/>\n";
+    }
+    text += "</svg>\n";
+    const auto elapsed_ns = [](const auto start) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    bz::svg_document_t document;
+    auto start = std::chrono::steady_clock::now();
+    bz::parse_svg(text, &document);
+    print_result("svg parse (nanosvg)", elapsed_ns(start) / count, 0.0);
+
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bz::bake_library_t serial, parallel;
+    start = std::chrono::steady_clock::now();
+    const bool baked = bz::bake_svg_document(&serial, document, BZ_BAKE_TOLERANCE, 1) >= 0;
+    const double serial_ns = elapsed_ns(start) / count;
+    if (!baked) {
+        std::printf("svg bake recusado: algum caminho passa da tolerância %.3g\n", BZ_BAKE_TOLERANCE);
+        return;
+    }
+    double error = 0.0;
+    std::size_t samples = 0;
+    for (const bz::baked_path_t& path : serial.paths) {
+        error = std::max(error, (double) path.error);
+        samples += path.samples.size();
+    }
+    print_result("svg bake 1 thread", serial_ns, error);
+    // Com um core só a segunda passada repetiria a primeira
+    if (threads > 1) {
+        start = std::chrono::steady_clock::now();
+        bz::bake_svg_document(&parallel, document, BZ_BAKE_TOLERANCE, threads);
+        const double parallel_ns = elapsed_ns(start) / count;
+        char name[64];
+        std::snprintf(name, sizeof(name), "svg bake %u threads", threads);
+        print_result(name, parallel_ns, error);
+    }
+    std::printf("%d caminhos, %.1f amostras por caminho\n", count, (double) samples / count);
+}
+
+
+/**
+ * Rasterizador em CPU: bullets (círculos de raio 4) e curvas (traço de 2 px)
+ * numa imagem 1080x720, com 1 thread e com todas. Tempo por forma.
+*/
+void bench_raster(const bench_options_t& options) {
+    bench_options_t frames = options;
+    frames.frames = std::max(1, options.frames / 20);
+    std::vector<bz::bezier_animation_t> animations = make_animations(options.bullets, 2, true);
+    Image image = GenImageColor(1080, 720, BLACK);
+    bz::rasterizer_t rasterizer;
+    // Com um core só a passada com todas as threads repetiria a de 1
+    std::vector<unsigned> thread_counts = {1u};
+    if (std::thread::hardware_concurrency() > 1) {
+        thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+    for (const unsigned threads : thread_counts) {
+        const double circles_ns = time_frames(frames, [&](int) {
+            bz::begin_raster(&rasterizer, image.width, image.height);
+            for (bz::bezier_animation_t& a : animations) {
+                bz::animation_update(&a, options.dt);
+                bz::raster_circle(&rasterizer, a.C, 4.f, YELLOW);
+            }
+            bz::rasterize(&rasterizer, &image, threads);
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "raster bullets %u threads", threads);
+        print_result(name, circles_ns, 0.0);
+    }
+    bench_options_t curves = frames;
+    curves.bullets = std::max(1, options.bullets / 100);
+    for (const unsigned threads : thread_counts) {
+        const double curves_ns = time_frames(curves, [&](int) {
+            bz::begin_raster(&rasterizer, image.width, image.height);
+            for (int i = 0; i < curves.bullets; i++) {
+                const auto& p = animations[i].control_points;
+                bz::raster_curve(&rasterizer, p.data(), p.size(), 2.f, WHITE);
+            }
+            bz::rasterize(&rasterizer, &image, threads);
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "raster curvas %u threads", threads);
+        print_result(name, curves_ns, 0.0);
+    }
+    UnloadImage(image);
+}
+
+
+typedef struct benchmark {
+    const char* name;
+    void (*run)(const bench_options_t&);
+} benchmark_t;
+
+const benchmark_t benchmarks[] = {
+    {"stepper", bench_stepper},
+    {"bake", bench_bake},
+    {"quantized", bench_quantized},
+    {"compact", bench_compact},
+    {"dispatch", bench_dispatch},
+    {"static", bench_static},
+    {"scalar", bench_scalar},
+    {"easing", bench_easing},
+    {"compose", bench_compose},
+    {"svg", bench_svg},
+    {"raster", bench_raster},
+};
+
+
+int main(int argc, char** argv) {
+    bench_options_t options{};
+    const char* only = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--bullets") == 0 && i + 1 < argc) {
+            options.bullets = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else {
+            only = argv[i];
+        }
+    }
+    bool found = false;
+    for (const benchmark_t& b : benchmarks) {
+        if (only == NULL || std::strcmp(only, b.name) == 0) {
+            std::printf("== %s (%d animações, %d frames)\n", b.name, options.bullets, options.frames);
+            b.run(options);
+            found = true;
+        }
+    }
+    if (!found) {
+        std::fprintf(stderr, "benchmark desconhecido: %s\n", only);
+        return 1;
+    }
+    return 0;
+}
@@ -1,9 +1,12 @@
 #ifndef BEZIER_CURVE_H
 #define BEZIER_CURVE_H
 #include <raylib.h>
+#include "bezier_profile.h"
 #include <raymath.h>
 #include <cmath>
+#include <cstdint>
 #include <vector>
+#include <memory_resource>
 #include <cassert>
 #include <algorithm>
 
@@ -11,7 +14,12 @@
 namespace bz {
 
 
-    enum TBasicFunction {
+    /**
+     * Valores a partir de BZ_EASING_BUILTIN_COUNT (bezier_easing.h) são ids de
+     * funções cubic-bezier, só lidos por animation_update_eased; os outros
+     * updates não os conhecem e param num assert.
+    */
+    enum TBasicFunction : int {
         Normal,
         Quadratic,
         Cubic,
@@ -20,8 +28,11 @@ namespace bz {
         Parabola   
     };
 
-    typedef struct bezier_animation {        
-        std::vector<Vector2> control_points; // Pontos de controle da animação    
+    /**
+     * Estado de tempo da animação. Fica separado dos pontos de controle para que
+     * a cópia com outro memory_resource copie todo o resto de uma vez.
+    */
+    typedef struct animation_state {
         Vector2 C; // Ponto que vai de start até target atraves do tempo t             
         double time_to_complete = 0.0;
         double time_count = 0.0;
@@ -29,17 +40,90 @@ namespace bz {
         bool reverse = false;
         bool loop = false;
         TBasicFunction t_function = bz::TBasicFunction::Normal; // Função a ser aplicada ao valor de t
-        bezier_animation(const Vector2 start, const Vector2 end) {
+        std::uint32_t id = 0; // Identidade do bullet no trace (bezier_trace.h); 0 = ainda sem id
+    } animation_state_t;
+
+    #define BZ_STEPPER_RESEED 240 // Passos até recalcular a tabela de diferenças do zero
+
+    /**
+     * Tabela de diferenças progressivas do modo stepping (ver animation_update_stepped).
+     * table = [B, Δ¹B, ..., ΔⁿB] de x seguido do mesmo para y, no t atual.
+     * Fica fora da bezier_animation_t, numa tabela paralela às animações que
+     * usam stepping, para não pesar nas que não usam.
+    */
+    typedef struct forward_stepper {
+        using allocator_type = std::pmr::polymorphic_allocator<double>;
+        std::pmr::vector<double> table;
+        float dt = 0.f;                  // dt usado no último seed
+        int steps = BZ_STEPPER_RESEED;   // Passos desde o último seed
+        forward_stepper() = default;
+        explicit forward_stepper(const allocator_type alloc) : table(alloc) { }
+        forward_stepper(const forward_stepper& other) = default;
+        forward_stepper(forward_stepper&& other) = default;
+        forward_stepper(const forward_stepper& other, const allocator_type alloc)
+            : table(other.table, alloc), dt(other.dt), steps(other.steps) { }
+        forward_stepper(forward_stepper&& other, const allocator_type alloc)
+            : table(std::move(other.table), alloc), dt(other.dt), steps(other.steps) { }
+        forward_stepper& operator=(const forward_stepper& other) = default;
+        forward_stepper& operator=(forward_stepper&& other) = default;
+    } forward_stepper_t;
+
+    /**
+     * Curva de grau fixo (bz::bezier<N, Scalar>, ver bezier_static.h) usada por
+     * uma bezier_animation_t no lugar dos pontos de controle. A curva não é
+     * copiada: precisa viver mais que a animação (normalmente é constexpr/static).
+    */
+    typedef struct fixed_curve {
+        const void* curve = NULL;
+        Vector2 (*evaluate)(const void* curve, double t) = NULL;
+    } fixed_curve_t;
+
+    /**
+     * Os pontos de controle usam std::pmr. Como a animação declara allocator_type,
+     * um std::pmr::vector<bezier_animation_t> constrói seus elementos com o
+     * memory_resource do próprio container (arena, pool...).
+    */
+    typedef struct bezier_animation : animation_state {        
+        using allocator_type = std::pmr::polymorphic_allocator<Vector2>;
+        std::pmr::vector<Vector2> control_points; // Pontos de controle da animação    
+        fixed_curve_t fixed;       // Se evaluate != NULL, avalia por ela (ver bz::wrap)
+        bezier_animation(const Vector2 start, const Vector2 end, const allocator_type alloc = {})
+            : control_points(alloc) {
             control_points.push_back(start);
             control_points.push_back(end);
         }
         bezier_animation() = default;
+        explicit bezier_animation(const allocator_type alloc) : control_points(alloc) { }
+        bezier_animation(const bezier_animation& other) = default;
+        bezier_animation(bezier_animation&& other) = default;
+        bezier_animation(const bezier_animation& other, const allocator_type alloc)
+            : animation_state(other),
+              control_points(other.control_points, alloc),
+              fixed(other.fixed) { }
+        bezier_animation(bezier_animation&& other, const allocator_type alloc)
+            : animation_state(other),
+              control_points(std::move(other.control_points), alloc),
+              fixed(other.fixed) { }
+        bezier_animation& operator=(const bezier_animation& other) = default;
+        bezier_animation& operator=(bezier_animation&& other) = default;
+        allocator_type get_allocator() const {
+            return control_points.get_allocator();
+        }
     } bezier_animation_t;
 
+    /**
+     * Chamada por toda função do bz que muda os pontos de controle: uma curva
+     * fixa deixa de valer
+    */
+    void control_points_changed(bz::bezier_animation_t* animation) {
+        animation->fixed = {};
+    }
+
     void sort_control_points(bz::bezier_animation_t* animation) {
         if (animation->control_points.empty()) {
             return;
         }
+        bz::control_points_changed(animation);
         const Vector2 start = animation->control_points[0];
         std::sort(
             animation->control_points.begin(),
@@ -51,10 +135,12 @@ namespace bz {
     }
 
     void push_back_control_point(bz::bezier_animation_t* animation, const Vector2 point) {
+        bz::control_points_changed(animation);
         animation->control_points.push_back(point);
     }
 
     void push_front_control_point(bz::bezier_animation_t* animation, const Vector2 point) {
+        bz::control_points_changed(animation);
         animation->control_points.insert(animation->control_points.begin(), point);
     }
 
@@ -64,16 +150,19 @@ namespace bz {
         const std::size_t i
     ) {
         assert(i < animation->control_points.size());
+        bz::control_points_changed(animation);
         animation->control_points.insert(animation->control_points.begin() + i, point);
     }
 
     void remove_control_point(bz::bezier_animation_t* animation, const std::size_t i) {
         assert(i < animation->control_points.size());
+        bz::control_points_changed(animation);
         animation->control_points.erase(animation->control_points.begin() + i);        
     }
 
     void change_end_point(bz::bezier_animation_t* animation, const Vector2 point) {
         assert(animation->control_points.empty() == false);
+        bz::control_points_changed(animation);
         animation->control_points[animation->control_points.size() - 1] = point;
     }
 
@@ -113,19 +202,25 @@ namespace bz {
                 break;
             case TBasicFunction::QuadraticEasyOut:
                 return 1.0 - (1.0 - t) * (1.0 -t);                
-            case TBasicFunction::Parabola:
-                return std::pow(4.0 * t * (1.0 - t), 2);                
+            case TBasicFunction::Parabola: {
+                const double u = 4.0 * t * (1.0 - t);
+                return u * u;
+            }
             default:            
+                assert(f == TBasicFunction::Normal && "Id de cubic-bezier: use animation_update_eased (bezier_easing.h)!");
                 break;  
         }
         return t;
     }
 
-    bool is_animation_complete(bz::bezier_animation_t* animation) {
+    bool is_animation_complete(bz::animation_state_t* animation) {
         return (animation->time_count >= animation->time_to_complete);
     }
 
-    double update_progress(bz::bezier_animation_t* animation, const float dt) {
+    /**
+     * Avança o tempo e retorna o t linear, sem a t_function
+    */
+    double advance_time(bz::animation_state_t* animation, const float dt) {
         animation->time_count += dt;        
         animation->t = animation->time_count / animation->time_to_complete;
         animation->t = animation->reverse ? 1.0 - animation->t : animation->t;
@@ -133,9 +228,73 @@ namespace bz {
             animation->reverse = animation->loop ? !animation->reverse : false;
             animation->time_count = 0.0;
         } 
-        return bz::apply_t_function(animation->t_function, animation->t);
+        return animation->t;
+    }
+
+    double update_progress(bz::animation_state_t* animation, const float dt) {
+        return bz::apply_t_function(animation->t_function, bz::advance_time(animation, dt));
     }    
 
+    /**
+     * Soma de Bernstein genérica, para qualquer grau
+    */
+    Vector2 evaluate_generic(const Vector2* points, const int count, const double t) {
+        const int n = count - 1;
+        Vector2 C = Vector2Zero();
+        for (int k = 0; k < n+1; k++) {
+            const double b_coeff = binomial_coefficient(n, k);
+            const double bernstein_poly = b_coeff * pow(t, k) * pow(1.0 - t, n - k);
+            C = Vector2Add(C, Vector2Scale(points[k], bernstein_poly));
+        }
+        return C;
+    }
+
+    /**
+     * Formas fechadas dos graus 1, 2 e 3 (as mesmas de GetSplinePointLinear,
+     * GetSplinePointBezierQuad e GetSplinePointBezierCubic do raylib)
+    */
+    Vector2 evaluate_linear(const Vector2* p, const double t) {
+        const double s = 1.0 - t;
+        return {(float) (s * p[0].x + t * p[1].x), (float) (s * p[0].y + t * p[1].y)};
+    }
+
+    Vector2 evaluate_quadratic(const Vector2* p, const double t) {
+        const double s = 1.0 - t;
+        const double b0 = s * s, b1 = 2.0 * s * t, b2 = t * t;
+        return {
+            (float) (b0 * p[0].x + b1 * p[1].x + b2 * p[2].x),
+            (float) (b0 * p[0].y + b1 * p[1].y + b2 * p[2].y)
+        };
+    }
+
+    Vector2 evaluate_cubic(const Vector2* p, const double t) {
+        const double s = 1.0 - t;
+        const double b0 = s * s * s, b1 = 3.0 * s * s * t, b2 = 3.0 * s * t * t, b3 = t * t * t;
+        return {
+            (float) (b0 * p[0].x + b1 * p[1].x + b2 * p[2].x + b3 * p[3].x),
+            (float) (b0 * p[0].y + b1 * p[1].y + b2 * p[2].y + b3 * p[3].y)
+        };
+    }
+
+    /**
+     * Escolhe o kernel pelo número de pontos de controle
+    */
+    Vector2 evaluate_curve(const Vector2* points, const int count, const double t) {
+        switch (count) {
+            case 1:
+                return points[0];
+            case 2:
+                return evaluate_linear(points, t);
+            case 3:
+                return evaluate_quadratic(points, t);
+            case 4:
+                return evaluate_cubic(points, t);
+            default:
+                break;
+        }
+        return evaluate_generic(points, count, t);
+    }
+
     /**
      * Atualiza a posição do ponto C em relação a um tempo t
     */
@@ -143,14 +302,13 @@ namespace bz {
         bezier_animation_t* animation, 
         const float dt
     ) {                
+        BZ_PROFILE_ZONE("animation_update");
         const double t = bz::update_progress(animation, dt);
-        const int n = animation->control_points.size() - 1;        
-        animation->C = Vector2Zero();
-        for (int k = 0; k < n+1; k++) {
-            const double b_coeff = binomial_coefficient(n, k);
-            const double bernstein_poly = b_coeff * pow(t, k) * pow(1.0 - t, n - k);
-            animation->C = Vector2Add(animation->C, Vector2Scale(animation->control_points[k], bernstein_poly));
-        }        
+        if (animation->fixed.evaluate != NULL) {
+            animation->C = animation->fixed.evaluate(animation->fixed.curve, t);
+            return;
+        }
+        animation->C = bz::evaluate_curve(animation->control_points.data(), animation->control_points.size(), t);
     }
 
     void animation_update_follows_target(
@@ -158,15 +316,106 @@ namespace bz {
         const float dt,
         const Vector2 target
     ) {
+        BZ_PROFILE_ZONE("animation_update_follows_target");
         animation->control_points[animation->control_points.size() - 1] = target;
         const double t = bz::update_progress(animation, dt);
-        const int n = animation->control_points.size() - 1;        
-        animation->C = Vector2Zero();
+        animation->C = bz::evaluate_curve(animation->control_points.data(), animation->control_points.size(), t);
+    }
+
+    #define BZ_STEPPER_MIN_POINTS 5 // Abaixo disso os kernels de evaluate_curve são mais rápidos (benchmark "stepper")
+    #define BZ_STEPPER_MAX_POINTS 6 // Acima disso o erro das diferenças acumula demais em BZ_STEPPER_RESEED passos
+
+    /**
+     * Força um novo seed no próximo passo. Com stepping, chamar sempre que os
+     * pontos de controle da animação mudarem.
+    */
+    void reset_stepper(forward_stepper_t* stepper) {
+        stepper->steps = BZ_STEPPER_RESEED;
+    }
+
+    /**
+     * Ponto da curva em t, em double (usado no seed da tabela de diferenças)
+    */
+    void bezier_point(const Vector2* points, const int n, const double t, double* x, double* y) {
+        *x = 0.0;
+        *y = 0.0;
         for (int k = 0; k < n+1; k++) {
-            const double b_coeff = binomial_coefficient(n, k);
-            const double bernstein_poly = b_coeff * pow(t, k) * pow(1.0 - t, n - k);
-            animation->C = Vector2Add(animation->C, Vector2Scale(animation->control_points[k], bernstein_poly));
-        }     
+            const double bernstein_poly = binomial_coefficient(n, k) * pow(t, k) * pow(1.0 - t, n - k);
+            *x += points[k].x * bernstein_poly;
+            *y += points[k].y * bernstein_poly;
+        }
+    }
+
+    /**
+     * Recalcula a tabela: avalia a curva em t, t+h, ..., t+n*h e tira as diferenças
+    */
+    void seed_stepper(const bz::bezier_animation_t* animation, forward_stepper_t* stepper, const double t, const double h, const float dt) {
+        forward_stepper_t& s = *stepper;
+        const int n = animation->control_points.size() - 1;
+        s.table.resize(2 * (n + 1));
+        double* x = s.table.data();
+        double* y = x + n + 1;
+        for (int i = 0; i <= n; i++) {
+            bezier_point(animation->control_points.data(), n, t + i * h, x + i, y + i);
+        }
+        for (int k = 1; k <= n; k++) {
+            for (int i = n; i >= k; i--) {
+                x[i] -= x[i - 1];
+                y[i] -= y[i - 1];
+            }
+        }
+        s.dt = dt;
+        s.steps = 0;
+    }
+
+    /**
+     * Modo stepping: com dt constante o t avança sempre o mesmo passo, e um
+     * polinômio de grau n pode ser avançado com n somas por coordenada usando
+     * diferenças progressivas em vez de avaliar a curva. A tabela (stepper,
+     * uma por animação, guardada pelo chamador) é refeita quando o dt muda,
+     * quando a animação inverte/volta ao início e a cada BZ_STEPPER_RESEED
+     * passos, para limitar o acúmulo de erro.
+     * Só é usado entre BZ_STEPPER_MIN_POINTS e BZ_STEPPER_MAX_POINTS pontos
+     * (graus 4 e 5) e com TBasicFunction::Normal; nos outros casos a animação
+     * é avaliada diretamente. Se os pontos de controle mudarem, chamar
+     * reset_stepper.
+    */
+    void animation_update_stepped(
+        bz::bezier_animation_t* animation,
+        forward_stepper_t* stepper,
+        const float dt
+    ) {
+        BZ_PROFILE_ZONE("animation_update_stepped");
+        const int n = (int) animation->control_points.size() - 1;
+        if (n + 1 < BZ_STEPPER_MIN_POINTS || n + 1 > BZ_STEPPER_MAX_POINTS || animation->fixed.evaluate != NULL ||
+            animation->t_function != TBasicFunction::Normal) {
+            bz::animation_update(animation, dt);
+            return;
+        }
+        forward_stepper_t& s = *stepper;
+        const bool reverse = animation->reverse;
+        const double t = bz::update_progress(animation, dt);
+        if (animation->reverse != reverse) {
+            // Voltou ao início: este frame é avaliado direto e o próximo refaz a tabela
+            double x, y;
+            bezier_point(animation->control_points.data(), n, t, &x, &y);
+            animation->C = {(float) x, (float) y};
+            s.steps = BZ_STEPPER_RESEED;
+            return;
+        }
+        if (s.steps >= BZ_STEPPER_RESEED || s.dt != dt || (int) s.table.size() != 2 * (n + 1)) {
+            const double h = (animation->reverse ? -dt : dt) / animation->time_to_complete;
+            seed_stepper(animation, stepper, t, h, dt);
+        } else {
+            double* x = s.table.data();
+            double* y = x + n + 1;
+            for (int k = 0; k < n; k++) {
+                x[k] += x[k + 1];
+                y[k] += y[k + 1];
+            }
+            s.steps++;
+        }
+        animation->C = {(float) s.table[0], (float) s.table[n + 1]};
     }
 
 }  // namespace bz
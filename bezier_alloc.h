@@ -0,0 +1,187 @@
+#ifndef BEZIER_ALLOC_H
+#define BEZIER_ALLOC_H
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+
+/**
+ * Contagem de alocações no heap e regiões sem alocação.
+ *
+ * Com BZ_ALLOC_HOOKS este header substitui os operator new/delete globais,
+ * então deve ser incluído em apenas um arquivo .cpp do executável.
+ * Sem BZ_ALLOC_HOOKS as estatísticas ficam zeradas e BZ_NO_ALLOC_REGION não faz nada.
+ *
+ * Com o trap ligado (set_trap(true)) qualquer alocação dentro de uma região
+ * marcada com BZ_NO_ALLOC_REGION aborta o programa indicando a região.
+*/
+#if defined(BZ_ALLOC_HOOKS)
+    #define BZ_ALLOC_CONCAT_(a, b) a##b
+    #define BZ_ALLOC_CONCAT(a, b) BZ_ALLOC_CONCAT_(a, b)
+    #define BZ_NO_ALLOC_REGION(name) bz::alloc::no_alloc_region_t BZ_ALLOC_CONCAT(bz_no_alloc_, __LINE__)(name)
+#else
+    #define BZ_NO_ALLOC_REGION(name) ((void) 0)
+#endif
+
+
+namespace bz {
+
+namespace alloc {
+
+
+    typedef struct stats {
+        std::size_t allocations = 0;
+        std::size_t frees = 0;
+        std::size_t bytes = 0; // Bytes pedidos (os frees não são descontados)
+    } stats_t;
+
+    stats_t operator-(const stats_t& l, const stats_t& r) {
+        return {l.allocations - r.allocations, l.frees - r.frees, l.bytes - r.bytes};
+    }
+
+    stats_t operator+(const stats_t& l, const stats_t& r) {
+        return {l.allocations + r.allocations, l.frees + r.frees, l.bytes + r.bytes};
+    }
+
+#if defined(BZ_ALLOC_HOOKS)
+
+    std::atomic<std::size_t> allocations{0};
+    std::atomic<std::size_t> frees{0};
+    std::atomic<std::size_t> bytes{0};
+    std::atomic<bool> trap{false};
+    thread_local const char* region = NULL;
+    thread_local int region_depth = 0;
+
+    constexpr bool available() {
+        return true;
+    }
+
+    stats_t snapshot() {
+        return {
+            allocations.load(std::memory_order_relaxed),
+            frees.load(std::memory_order_relaxed),
+            bytes.load(std::memory_order_relaxed)
+        };
+    }
+
+    void set_trap(const bool enabled) {
+        trap.store(enabled, std::memory_order_relaxed);
+    }
+
+    typedef struct no_alloc_region {
+        const char* previous;
+        explicit no_alloc_region(const char* name) : previous(region) {
+            region = name;
+            region_depth++;
+        }
+        ~no_alloc_region() {
+            region = previous;
+            region_depth--;
+        }
+        no_alloc_region(const no_alloc_region&) = delete;
+        no_alloc_region& operator=(const no_alloc_region&) = delete;
+    } no_alloc_region_t;
+
+    void* allocate(const std::size_t size, const std::size_t alignment) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        if (region_depth > 0 && trap.load(std::memory_order_relaxed)) {
+            region_depth = 0; // evita recursão caso o fprintf aloque
+            std::fprintf(stderr, "bz::alloc: alocação de %zu bytes dentro da região \"%s\"\n", size, region);
+            std::abort();
+        }
+        void* p = alignment > alignof(std::max_align_t)
+            ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+            : std::malloc(size == 0 ? 1 : size);
+        if (p == NULL) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void deallocate(void* p) {
+        if (p != NULL) {
+            frees.fetch_add(1, std::memory_order_relaxed);
+            std::free(p);
+        }
+    }
+
+#else
+
+    constexpr bool available() {
+        return false;
+    }
+
+    stats_t snapshot() {
+        return {};
+    }
+
+    void set_trap(const bool enabled) {
+        (void) enabled;
+    }
+
+#endif
+
+
+}  // namespace alloc
+
+}  // namespace bz
+
+
+#if defined(BZ_ALLOC_HOOKS)
+
+void* operator new(std::size_t size) {
+    return bz::alloc::allocate(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+    return bz::alloc::allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return bz::alloc::allocate(size, (std::size_t) alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return bz::alloc::allocate(size, (std::size_t) alignment);
+}
+
+void operator delete(void* p) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+void operator delete[](void* p) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    bz::alloc::deallocate(p);
+}
+
+#endif
+
+
+
+#endif
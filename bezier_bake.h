@@ -0,0 +1,204 @@
+#ifndef BEZIER_BAKE_H
+#define BEZIER_BAKE_H
+#include "bezier.h"
+#include "bezier_template.h"
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <vector>
+
+
+/**
+ * Caminhos pré-amostrados ("baked") para animações que se repetem.
+ *
+ * O caminho já com a t_function aplicada é amostrado uma vez em N pontos
+ * igualmente espaçados no tempo; cada frame vira uma busca na tabela com
+ * interpolação linear ou cúbica (Catmull-Rom). N é dobrado até o erro entre
+ * as amostras ficar abaixo da tolerância pedida.
+ * Interpolação linear e Catmull-Rom são combinações afins das amostras, então
+ * um caminho feito de um modelo (bezier_template.h) serve para qualquer
+ * transformação; a tolerância vale em coordenadas do modelo e é multiplicada
+ * pela escala da transformação.
+*/
+namespace bz {
+
+
+    #define BZ_BAKE_TOLERANCE 0.25 // Erro máximo padrão, em pixels
+    #define BZ_BAKE_MIN_SAMPLES 8
+    #define BZ_BAKE_MAX_SAMPLES 4096
+
+    enum TInterpolation {
+        LinearInterpolation,
+        CubicInterpolation
+    };
+
+    typedef struct baked_path {
+        std::vector<Vector2> samples; // samples[i] = B(f(i / (N - 1)))
+        TInterpolation interpolation = TInterpolation::LinearInterpolation;
+        float error = 0.f;            // Maior erro medido no bake
+    } baked_path_t;
+
+    /**
+     * Posição do caminho no tempo normalizado u (fora de [0, 1] fica no extremo)
+    */
+    Vector2 sample_baked_path(const baked_path_t& path, const double u) {
+        const int last = (int) path.samples.size() - 1;
+        const double x = std::clamp(u, 0.0, 1.0) * last;
+        const int i = std::min((int) x, last - 1);
+        const float f = (float) (x - i);
+        const Vector2* s = path.samples.data();
+        if (path.interpolation == TInterpolation::LinearInterpolation) {
+            return Vector2Lerp(s[i], s[i + 1], f);
+        }
+        // Catmull-Rom; nos extremos o ponto que falta é extrapolado linearmente
+        const Vector2 p1 = s[i];
+        const Vector2 p2 = s[i + 1];
+        const Vector2 p0 = i > 0 ? s[i - 1] : Vector2Subtract(Vector2Scale(p1, 2.f), p2);
+        const Vector2 p3 = i + 2 <= last ? s[i + 2] : Vector2Subtract(Vector2Scale(p2, 2.f), p1);
+        const float f2 = f * f;
+        const float f3 = f2 * f;
+        const float w0 = 0.5f * (-f3 + 2.f * f2 - f);
+        const float w1 = 0.5f * (3.f * f3 - 5.f * f2 + 2.f);
+        const float w2 = 0.5f * (-3.f * f3 + 4.f * f2 + f);
+        const float w3 = 0.5f * (f3 - f2);
+        return {
+            w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x,
+            w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y
+        };
+    }
+
+    /**
+     * Ponto exato da curva em u, com a t_function aplicada
+    */
+    Vector2 exact_path_point(const Vector2* points, const int count, const TBasicFunction t_function, const double u) {
+        const double t = bz::apply_t_function(t_function, u);
+        const int n = count - 1;
+        double x = 0.0, y = 0.0;
+        for (int k = 0; k <= n; k++) {
+            const double bernstein_poly = binomial_coefficient(n, k) * pow(t, k) * pow(1.0 - t, n - k);
+            x += points[k].x * bernstein_poly;
+            y += points[k].y * bernstein_poly;
+        }
+        return {(float) x, (float) y};
+    }
+
+    /**
+     * Amostra a curva dobrando a resolução até o erro medido no meio e nos
+     * quartos de cada intervalo ficar abaixo de tolerance. Retorna false se
+     * BZ_BAKE_MAX_SAMPLES não bastar (o caminho fica com a resolução máxima).
+    */
+    bool bake_curve(
+        const Vector2* points,
+        const int count,
+        const TBasicFunction t_function,
+        const TInterpolation interpolation,
+        const double tolerance,
+        baked_path_t* out
+    ) {
+        assert(count > 1 && "Curva precisa de pelo menos 2 pontos de controle!");
+        out->interpolation = interpolation;
+        for (int n = BZ_BAKE_MIN_SAMPLES; n <= BZ_BAKE_MAX_SAMPLES; n *= 2) {
+            out->samples.resize(n);
+            for (int i = 0; i < n; i++) {
+                out->samples[i] = exact_path_point(points, count, t_function, (double) i / (n - 1));
+            }
+            double error = 0.0;
+            for (int i = 0; i < n - 1; i++) {
+                for (int q = 1; q < 4; q++) {
+                    const double u = (i + q / 4.0) / (n - 1);
+                    const Vector2 expected = exact_path_point(points, count, t_function, u);
+                    const Vector2 got = sample_baked_path(*out, u);
+                    error = std::max(error, (double) Vector2Distance(expected, got));
+                }
+            }
+            out->error = (float) error;
+            if (error <= tolerance) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Caminhos compartilhados. Os feitos de um modelo ficam indexados por
+     * (modelo, t_function, interpolação) e são amostrados uma vez só.
+    */
+    typedef struct bake_library {
+        std::vector<baked_path_t> paths;
+        std::map<std::tuple<int, int, int>, int> template_paths;
+    } bake_library_t;
+
+    int add_baked_path(
+        bake_library_t* library,
+        const Vector2* points,
+        const int count,
+        const TBasicFunction t_function,
+        const TInterpolation interpolation = TInterpolation::CubicInterpolation,
+        const double tolerance = BZ_BAKE_TOLERANCE
+    ) {
+        baked_path_t path{};
+        bz::bake_curve(points, count, t_function, interpolation, tolerance, &path);
+        library->paths.push_back(std::move(path));
+        return (int) library->paths.size() - 1;
+    }
+
+    /**
+     * Libera a memória dos caminhos [first, first + count). Os ids dos outros
+     * caminhos continuam válidos: no fim da biblioteca o intervalo é removido,
+     * no meio os caminhos só ficam vazios (e não podem mais ser amostrados).
+    */
+    void release_baked_paths(bake_library_t* library, const int first, const int count) {
+        if (first + count == (int) library->paths.size()) {
+            library->paths.resize(first);
+            return;
+        }
+        for (int i = first; i < first + count; i++) {
+            library->paths[i] = baked_path_t{};
+        }
+    }
+
+    int bake_template(
+        bake_library_t* library,
+        const template_library_t& templates,
+        const int template_id,
+        const TBasicFunction t_function,
+        const TInterpolation interpolation = TInterpolation::CubicInterpolation,
+        const double tolerance = BZ_BAKE_TOLERANCE
+    ) {
+        const std::tuple<int, int, int> key{template_id, (int) t_function, (int) interpolation};
+        const auto it = library->template_paths.find(key);
+        if (it != library->template_paths.end()) {
+            return it->second;
+        }
+        const std::vector<Vector2>& points = templates.templates[template_id].control_points;
+        const int id = bz::add_baked_path(library, points.data(), points.size(), t_function, interpolation, tolerance);
+        library->template_paths[key] = id;
+        return id;
+    }
+
+    /**
+     * Animação sobre um caminho pré-amostrado. A t_function já está na tabela,
+     * então a do animation_state é ignorada.
+    */
+    typedef struct baked_animation : animation_state {
+        int path_id = -1;
+        transform2d_t transform;
+    } baked_animation_t;
+
+    void animation_update(
+        const bake_library_t* library,
+        baked_animation_t* animation,
+        const float dt
+    ) {
+        BZ_PROFILE_ZONE("baked_animation_update");
+        bz::advance_time(animation, dt);
+        const baked_path_t& path = library->paths[animation->path_id];
+        animation->C = transform_point(animation->transform, sample_baked_path(path, animation->t));
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef BEZIER_CAPTURE_H
+#define BEZIER_CAPTURE_H
+#include "raylib.h"
+#include "bezier_profile.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "external/msf_gif.h" // Implementação compilada dentro do raylib (SUPPORT_GIF_RECORDING)
+#include "external/glad.h"    // Só as declarações: os ponteiros são carregados pelo rlgl (OpenGL 3.3 do desktop)
+
+
+/**
+ * Gravação de GIF sem travar o frame.
+ *
+ * O frame só é copiado para um anel de buffers alocados no início; a
+ * quantização da paleta e a compressão LZW (msf_gif) rodam numa thread
+ * encoder. O msf_gif usa o frame anterior na compressão, então um GIF tem uma
+ * encoder só; gravações diferentes rodam em paralelo.
+ *
+ * Com o anel cheio, capture_frame descarta o frame (tempo real) ou espera a
+ * encoder (block = true, para captura offline/headless, onde nenhum frame
+ * pode ser perdido).
+*/
+namespace bz {
+
+
+    #define BZ_CAPTURE_RING 8      // Frames em espera de encode
+    #define BZ_CAPTURE_FPS 25      // Frames gravados por segundo (GIF conta em centésimos)
+    #define BZ_CAPTURE_BIT_DEPTH 16
+
+    typedef struct capture_slot {
+        std::vector<std::uint8_t> pixels; // RGBA
+        int pitch = 0;                    // Negativo quando as linhas estão de baixo para cima
+        int centiseconds = 0;
+    } capture_slot_t;
+
+    typedef struct gif_recorder {
+        int width = 0;
+        int height = 0;
+        std::FILE* file = NULL;
+        std::vector<capture_slot_t> ring;
+        std::atomic<std::uint32_t> head{0}; // Próximo slot a preencher (só a thread do jogo escreve)
+        std::atomic<std::uint32_t> tail{0}; // Próximo slot a codificar (só a encoder escreve)
+        std::atomic<bool> closing{false};
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::thread encoder;
+        MsfGifState state{};
+        double pending = 0.0;               // Tempo desde o último frame gravado
+        int frames = 0;
+        int dropped = 0;
+        bool ok = true;                     // false se a escrita/encode falhou
+    } gif_recorder_t;
+
+    std::size_t write_gif_chunk(const void* buffer, const std::size_t size, const std::size_t count, void* file) {
+        return std::fwrite(buffer, size, count, (std::FILE*) file);
+    }
+
+    void run_encoder(gif_recorder_t* recorder) {
+        for (;;) {
+            std::uint32_t tail = recorder->tail.load(std::memory_order_relaxed);
+            {
+                std::unique_lock<std::mutex> lock(recorder->mutex);
+                recorder->wake.wait(lock, [&]() {
+                    return recorder->head.load(std::memory_order_acquire) != tail || recorder->closing.load();
+                });
+                if (recorder->head.load(std::memory_order_acquire) == tail) {
+                    return; // Fechando e sem nada pendente
+                }
+            }
+            capture_slot_t& slot = recorder->ring[tail % recorder->ring.size()];
+            {
+                BZ_PROFILE_ZONE("gif_encode");
+                std::uint8_t* pixels = slot.pixels.data();
+                recorder->ok = msf_gif_frame_to_file(
+                    &recorder->state, pixels, slot.centiseconds, BZ_CAPTURE_BIT_DEPTH, slot.pitch
+                ) != 0 && recorder->ok;
+            }
+            {
+                // Dentro do lock: acquire_slot testa tail e dorme sob o mesmo mutex, então o aviso não se perde
+                std::lock_guard<std::mutex> lock(recorder->mutex);
+                recorder->tail.store(tail + 1, std::memory_order_release);
+            }
+            recorder->wake.notify_all();
+        }
+    }
+
+    /**
+     * Abre o arquivo, aloca o anel e inicia a encoder
+    */
+    bool begin_gif(gif_recorder_t* recorder, const char* path, const int width, const int height, const int ring = BZ_CAPTURE_RING) {
+        recorder->file = std::fopen(path, "wb");
+        if (recorder->file == NULL) {
+            return false;
+        }
+        if (!msf_gif_begin_to_file(&recorder->state, width, height, write_gif_chunk, recorder->file)) {
+            std::fclose(recorder->file);
+            recorder->file = NULL;
+            return false;
+        }
+        recorder->width = width;
+        recorder->height = height;
+        recorder->ring.resize(ring);
+        for (capture_slot_t& slot : recorder->ring) {
+            slot.pixels.resize((std::size_t) width * height * 4);
+        }
+        recorder->head = 0;
+        recorder->tail = 0;
+        recorder->closing = false;
+        recorder->pending = 0.0;
+        recorder->frames = 0;
+        recorder->dropped = 0;
+        recorder->ok = true;
+        recorder->encoder = std::thread(run_encoder, recorder);
+        return true;
+    }
+
+    bool is_recording(const gif_recorder_t& recorder) {
+        return recorder.file != NULL;
+    }
+
+    /**
+     * Slot livre para o próximo frame, ou NULL (anel cheio e block == false).
+     * Também decide se o frame entra no GIF (a cada 1 / BZ_CAPTURE_FPS s).
+    */
+    capture_slot_t* acquire_slot(gif_recorder_t* recorder, const float dt, const bool block) {
+        recorder->pending += dt;
+        const double interval = 1.0 / BZ_CAPTURE_FPS;
+        if (recorder->frames > 0 && recorder->pending < interval) {
+            return NULL;
+        }
+        const std::uint32_t head = recorder->head.load(std::memory_order_relaxed);
+        const std::uint32_t size = recorder->ring.size();
+        if (head - recorder->tail.load(std::memory_order_acquire) >= size) {
+            if (!block) {
+                recorder->dropped++;
+                return NULL;
+            }
+            std::unique_lock<std::mutex> lock(recorder->mutex);
+            recorder->wake.wait(lock, [&]() { return head - recorder->tail.load(std::memory_order_acquire) < size; });
+        }
+        capture_slot_t* slot = &recorder->ring[head % size];
+        // O tempo que passou desde o último frame gravado vira a duração deste
+        slot->centiseconds = recorder->frames > 0 ? (int) (recorder->pending * 100.0 + 0.5) : (int) (100.0 / BZ_CAPTURE_FPS);
+        recorder->pending -= slot->centiseconds / 100.0;
+        return slot;
+    }
+
+    void publish_slot(gif_recorder_t* recorder) {
+        {
+            std::lock_guard<std::mutex> lock(recorder->mutex);
+            recorder->head.fetch_add(1, std::memory_order_release);
+        }
+        recorder->wake.notify_all();
+        recorder->frames++;
+    }
+
+    /**
+     * Copia um frame RGBA (ex.: Image do rasterizador em CPU, bezier_raster.h).
+     * Retorna false se o frame não entrou no GIF.
+    */
+    bool capture_frame(gif_recorder_t* recorder, const void* pixels, const float dt, const bool block = false) {
+        BZ_PROFILE_ZONE("capture_frame");
+        capture_slot_t* slot = bz::acquire_slot(recorder, dt, block);
+        if (slot == NULL) {
+            return false;
+        }
+        std::memcpy(slot->pixels.data(), pixels, slot->pixels.size());
+        slot->pitch = recorder->width * 4;
+        bz::publish_slot(recorder);
+        return true;
+    }
+
+    /**
+     * Frame da tela (chamar antes do EndDrawing). glReadPixels escreve direto
+     * no slot, sem alocar; as linhas vêm de baixo para cima e o pitch negativo
+     * faz o msf_gif começar pela última linha do buffer (RGBA: as linhas já
+     * são múltiplas de 4 bytes, o GL_PACK_ALIGNMENT padrão serve).
+    */
+    bool capture_screen(gif_recorder_t* recorder, const float dt) {
+        BZ_PROFILE_ZONE("capture_screen");
+        capture_slot_t* slot = bz::acquire_slot(recorder, dt, false);
+        if (slot == NULL) {
+            return false;
+        }
+        glReadPixels(0, 0, recorder->width, recorder->height, GL_RGBA, GL_UNSIGNED_BYTE, slot->pixels.data());
+        slot->pitch = -recorder->width * 4;
+        bz::publish_slot(recorder);
+        return true;
+    }
+
+    /**
+     * Espera a encoder terminar os frames pendentes e fecha o arquivo
+    */
+    bool end_gif(gif_recorder_t* recorder) {
+        if (recorder->file == NULL) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(recorder->mutex);
+            recorder->closing = true;
+        }
+        recorder->wake.notify_all();
+        recorder->encoder.join();
+        const bool ok = msf_gif_end_to_file(&recorder->state) != 0 && recorder->ok;
+        std::fclose(recorder->file);
+        recorder->file = NULL;
+        recorder->ring.clear();
+        recorder->ring.shrink_to_fit();
+        return ok;
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
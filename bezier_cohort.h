@@ -0,0 +1,97 @@
+#ifndef BEZIER_COHORT_H
+#define BEZIER_COHORT_H
+#include "bezier.h"
+#include <cstddef>
+
+
+/**
+ * Avaliação por coorte: animações com o mesmo grau, a mesma duração, o mesmo
+ * easing e criadas no mesmo tick (mesmo time_count) têm o mesmo t para sempre.
+ * A base de Bernstein é calculada uma vez por coorte por frame e aplicada a
+ * todos os membros como um produto [membros x (n+1)] pontos por (n+1) pesos.
+*/
+namespace bz {
+
+
+    #define BZ_COHORT_MAX_DEGREE 31
+
+    /**
+     * Pesos de Bernstein de grau n em t: out[k] = C(n,k) * t^k * (1-t)^(n-k)
+    */
+    void bernstein_basis(const int n, const double t, double* out) {
+        const double s = 1.0 - t;
+        double tk = 1.0;
+        for (int k = 0; k <= n; k++) {
+            out[k] = tk;
+            tk *= t;
+        }
+        double sk = 1.0;
+        for (int k = n; k >= 0; k--) {
+            out[k] *= sk * binomial_coefficient(n, k);
+            sk *= s;
+        }
+    }
+
+    /**
+     * Duas animações estão na mesma coorte se vão ter o mesmo t depois do update
+    */
+    bool same_cohort(const bezier_animation_t& l, const bezier_animation_t& r) {
+        return l.control_points.size() == r.control_points.size() &&
+            l.time_count == r.time_count &&
+            l.time_to_complete == r.time_to_complete &&
+            l.t_function == r.t_function &&
+            l.reverse == r.reverse &&
+            l.loop == r.loop;
+    }
+
+    /**
+     * Atualiza count animações contíguas. Cada sequência de membros da mesma
+     * coorte avança o tempo uma vez e compartilha a base; para a maior parte
+     * dos ganhos as animações devem estar agrupadas por grau e easing.
+    */
+    void cohort_update(
+        bezier_animation_t* animations,
+        const std::size_t count,
+        const float dt
+    ) {
+        BZ_PROFILE_ZONE("cohort_update");
+        double basis[BZ_COHORT_MAX_DEGREE + 1];
+        std::size_t i = 0;
+        while (i < count) {
+            bezier_animation_t& leader = animations[i];
+            const int n = leader.control_points.size() - 1;
+            std::size_t end = i + 1;
+            while (end < count && same_cohort(leader, animations[end])) {
+                end++;
+            }
+            if (n > BZ_COHORT_MAX_DEGREE) {
+                for (; i < end; i++) {
+                    bz::animation_update(&animations[i], dt);
+                }
+                continue;
+            }
+            const double t = bz::update_progress(&leader, dt);
+            bernstein_basis(n, t, basis);
+            for (std::size_t j = i; j < end; j++) {
+                bezier_animation_t& a = animations[j];
+                a.time_count = leader.time_count;
+                a.t = leader.t;
+                a.reverse = leader.reverse;
+                const Vector2* p = a.control_points.data();
+                double x = 0.0, y = 0.0;
+                for (int k = 0; k <= n; k++) {
+                    x += basis[k] * p[k].x;
+                    y += basis[k] * p[k].y;
+                }
+                a.C = {(float) x, (float) y};
+            }
+            i = end;
+        }
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
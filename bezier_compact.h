@@ -0,0 +1,129 @@
+#ifndef BEZIER_COMPACT_H
+#define BEZIER_COMPACT_H
+#include "bezier.h"
+#include "bezier_template.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * Registro compacto de bullet (<= 32 bytes) para a varredura de update.
+ *
+ * Um bezier_animation_t tem ~80 bytes fora os pontos de controle no heap
+ * (três doubles, C, dois bools, o enum e o vetor). Aqui os tempos são float,
+ * reverse/loop e o easing vão em um byte cada e a curva é o índice de um
+ * modelo em template_library_t, deslocado por uma translação própria do
+ * bullet, então cabem 2 bullets por linha de cache.
+ * O modelo é avaliado pelos kernels de evaluate_curve, sem o cache de
+ * evaluate_template (bullets com tempos diferentes quase nunca acertam).
+*/
+namespace bz {
+
+
+    #define BZ_COMPACT_REVERSE 0x1
+    #define BZ_COMPACT_LOOP 0x2
+
+    typedef struct compact_bullet {
+        Vector2 C = {0.f, 0.f};
+        float time_count = 0.f;
+        float time_to_complete = 1.f;
+        float t = 0.f;
+        Vector2 offset = {0.f, 0.f}; // Somado ao ponto do modelo
+        std::uint16_t curve = 0;     // Índice do modelo em template_library_t
+        std::uint8_t flags = 0;      // BZ_COMPACT_REVERSE | BZ_COMPACT_LOOP
+        std::uint8_t t_function = 0; // bz::TBasicFunction (só os nativos: ids de cubic-bezier não cabem)
+    } compact_bullet_t;
+
+    static_assert(sizeof(compact_bullet_t) <= 32, "compact_bullet_t deve caber em 32 bytes");
+
+    compact_bullet_t to_compact(
+        const animation_state_t& animation,
+        const int curve,
+        const Vector2 offset = {0.f, 0.f}
+    ) {
+        assert(curve >= 0 && curve <= UINT16_MAX);
+        assert(
+            animation.t_function >= TBasicFunction::Normal && animation.t_function <= TBasicFunction::Parabola &&
+            "compact_bullet_t só guarda os TBasicFunction nativos!"
+        );
+        compact_bullet_t bullet{};
+        bullet.C = animation.C;
+        bullet.time_count = (float) animation.time_count;
+        bullet.time_to_complete = (float) animation.time_to_complete;
+        bullet.t = (float) animation.t;
+        bullet.offset = offset;
+        bullet.curve = (std::uint16_t) curve;
+        bullet.flags = (animation.reverse ? BZ_COMPACT_REVERSE : 0) | (animation.loop ? BZ_COMPACT_LOOP : 0);
+        bullet.t_function = (std::uint8_t) animation.t_function;
+        return bullet;
+    }
+
+    /**
+     * Recria a animação completa, copiando os pontos de controle do modelo
+     * já deslocados
+    */
+    bezier_animation_t from_compact(
+        const compact_bullet_t& bullet,
+        const template_library_t& library,
+        const bezier_animation_t::allocator_type alloc = {}
+    ) {
+        bezier_animation_t animation(alloc);
+        const std::vector<Vector2>& points = library.templates[bullet.curve].control_points;
+        for (const Vector2& p : points) {
+            animation.control_points.push_back(Vector2Add(p, bullet.offset));
+        }
+        animation.C = bullet.C;
+        animation.time_count = bullet.time_count;
+        animation.time_to_complete = bullet.time_to_complete;
+        animation.t = bullet.t;
+        animation.reverse = (bullet.flags & BZ_COMPACT_REVERSE) != 0;
+        animation.loop = (bullet.flags & BZ_COMPACT_LOOP) != 0;
+        animation.t_function = (TBasicFunction) bullet.t_function;
+        return animation;
+    }
+
+    bool is_animation_complete(const compact_bullet_t& bullet) {
+        return bullet.time_count >= bullet.time_to_complete;
+    }
+
+    /**
+     * Mesma regra de update_progress, com os tempos em float
+    */
+    double update_progress(compact_bullet_t* bullet, const float dt) {
+        bullet->time_count += dt;
+        bullet->t = bullet->time_count / bullet->time_to_complete;
+        const bool reverse = (bullet->flags & BZ_COMPACT_REVERSE) != 0;
+        bullet->t = reverse ? 1.f - bullet->t : bullet->t;
+        if ((bullet->flags & BZ_COMPACT_LOOP) && (bullet->t > 1.f || bullet->t < 0.f)) {
+            bullet->flags ^= BZ_COMPACT_REVERSE;
+            bullet->time_count = 0.f;
+        }
+        return bz::apply_t_function((TBasicFunction) bullet->t_function, bullet->t);
+    }
+
+    /**
+     * Atualiza count bullets contíguos sobre os modelos da biblioteca
+    */
+    void animation_update(
+        const template_library_t* library,
+        compact_bullet_t* bullets,
+        const std::size_t count,
+        const float dt
+    ) {
+        BZ_PROFILE_ZONE("compact_animation_update");
+        for (std::size_t i = 0; i < count; i++) {
+            compact_bullet_t& bullet = bullets[i];
+            const double t = bz::update_progress(&bullet, dt);
+            const std::vector<Vector2>& points = library->templates[bullet.curve].control_points;
+            bullet.C = Vector2Add(bz::evaluate_curve(points.data(), points.size(), t), bullet.offset);
+        }
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -1,5 +1,7 @@
 #include "bezier.h"
+#include "platform.h"
 #include <iostream>
+#include <memory_resource>
 
 
 #define SCREEN_WIDTH 1080
@@ -20,9 +22,9 @@ typedef struct mouse {
 
 
 void handle_mouse(bz::bezier_animation_t* animation, mouse_t* mouse) {
-    const Vector2 mouse_pos = GetMousePosition();
-    bool right_mouse = IsMouseButtonReleased(MOUSE_RIGHT_BUTTON);
-    bool space = IsKeyPressed(KEY_SPACE);
+    const Vector2 mouse_pos = platform::mouse_position();
+    bool right_mouse = platform::mouse_button_released(MOUSE_RIGHT_BUTTON);
+    bool space = platform::key_pressed(KEY_SPACE);
 
     for (int i = 0; i < animation->control_points.size(); i++) {
         const bool circle_collide = CheckCollisionPointCircle(mouse_pos, animation->control_points[i], CIRCLE_RADIUS);
@@ -43,13 +45,13 @@ void handle_mouse(bz::bezier_animation_t* animation, mouse_t* mouse) {
         }
     }
 
-    if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
+    if (platform::mouse_button_released(MOUSE_LEFT_BUTTON)) {
         mouse->dragged = false;
         mouse->last_circle_dragged = -1;
         return;
     }
 
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    if (platform::mouse_button_pressed(MOUSE_LEFT_BUTTON)) {
         mouse->dragged = true;
         mouse->last_circle_dragged = -1;
     }
@@ -62,6 +64,7 @@ void handle_mouse(bz::bezier_animation_t* animation, mouse_t* mouse) {
 
 
 void draw_animation(bz::bezier_animation_t* animation) {
+    BZ_PROFILE_ZONE("draw");
     const int n = animation->control_points.size();
     for (int i = 0; i < n; i++) {
         DrawCircleV(animation->control_points[i], CIRCLE_RADIUS, i == 0 || i == n - 1 ? RED : BROWN);
@@ -73,13 +76,28 @@ void draw_animation(bz::bezier_animation_t* animation) {
 }
 
 
+// Roteiro padrão do modo headless: arrasta um ponto de controle e insere outro
+#define HEADLESS_SCRIPT \
+    "0 mouse 376.667 256.667\n" \
+    "10 button LEFT down\n" \
+    "20 mouse 300 500\n" \
+    "40 mouse 200 600\n" \
+    "60 button LEFT up\n" \
+    "80 mouse 540 360\n" \
+    "90 button RIGHT down\n" \
+    "91 button RIGHT up\n"
+
+
 int main(int argc, char const *argv[]) {
-    SetConfigFlags(FLAG_VSYNC_HINT);
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_TITLE);    
+    const platform::options_t options = platform::parse_args(argc, argv);
+    platform::init(options, SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_TITLE, HEADLESS_SCRIPT);
     mouse_t mouse{};
+    // Inserir/remover pontos reaproveita os blocos do pool em vez de ir ao malloc
+    std::pmr::unsynchronized_pool_resource curve_pool;
     bz::bezier_animation_t animation = {
         {PADDING, PADDING},
         {SCREEN_WIDTH - PADDING, SCREEN_HEIGHT - PADDING},
+        &curve_pool
     };
     animation.time_to_complete = 5.0;
     animation.loop = true;
@@ -88,8 +106,14 @@ int main(int argc, char const *argv[]) {
         bz::add_control_point_lerp(&animation, STEP*(i+1));
     }    
     
-    while (!WindowShouldClose()) {
-        const float dt = GetFrameTime();
+    while (!platform::should_close()) {
+        platform::begin_frame();
+        const float dt = platform::frame_time();
+        if (platform::is_headless()) {
+            handle_mouse(&animation, &mouse);
+            bz::animation_update(&animation, dt);
+            continue;
+        }
         BeginDrawing();
         ClearBackground(GetColor(0x181818ff));
             handle_mouse(&animation, &mouse);
@@ -98,6 +122,6 @@ int main(int argc, char const *argv[]) {
         EndDrawing();
     }
         
-    CloseWindow();
+    platform::close();
     return 0;
 }
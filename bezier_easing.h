@@ -0,0 +1,297 @@
+#ifndef BEZIER_EASING_H
+#define BEZIER_EASING_H
+#include "bezier.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+
+/**
+ * Easings em lote.
+ *
+ * apply_t_function é um switch por chamada. Aqui o id do easing é escolhido por
+ * animação (a t_function, que também guarda os ids de cubic-bezier), mas
+ * animation_update_eased agrupa os t por id com counting sort e roda um kernel
+ * por grupo, então o laço de cada kernel não tem desvio por bullet.
+ *
+ * Ids 0..BZ_EASING_BUILTIN_COUNT-1 são os TBasicFunction; os seguintes são
+ * funções cubic-bezier(x1, y1, x2, y2) no estilo do CSS, resolvidas por uma
+ * tabela x -> t seguida de um passo de Newton. Para usar uma delas:
+ *   animation.t_function = bz::easing_function(bz::add_cubic_bezier(&library, ...));
+*/
+namespace bz {
+
+
+    #define BZ_EASING_BUILTIN_COUNT 6
+    static_assert(BZ_EASING_BUILTIN_COUNT == TBasicFunction::Parabola + 1, "ids de cubic-bezier começam depois dos TBasicFunction");
+    #define BZ_CUBIC_BEZIER_TABLE 32 // Intervalos da tabela x -> t
+
+    /**
+     * Raiz quadrada sem a instrução de hardware: chute pelos bits + 2 passos de
+     * Newton (erro ~4e-7 em [0, 1]). Com SSE o lote usa _mm_sqrt_ps, que é mais rápida.
+    */
+    float fast_sqrt(const float x) {
+        if (x <= 0.f) {
+            return 0.f;
+        }
+        std::uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        bits = 0x1fbd1df5 + (bits >> 1);
+        float y;
+        std::memcpy(&y, &bits, sizeof(y));
+        y = 0.5f * (y + x / y);
+        return 0.5f * (y + x / y);
+    }
+
+    /**
+     * log2 por expoente + polinômio de grau 5 na mantissa (erro ~3e-5)
+    */
+    float fast_log2(const float x) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        const int e = (int) ((bits >> 23) & 0xff) - 127;
+        bits = (bits & 0x007fffff) | 0x3f800000;
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+        m -= 1.f;
+        return e + m * (1.4418251f + m * (-0.70867494f + m * (0.41539777f + m * (-0.19439043f + m * 0.045870752f))));
+    }
+
+    /**
+     * 2^x por parte inteira no expoente + polinômio de grau 4 na fração (erro relativo ~5e-6)
+    */
+    float fast_exp2(const float x) {
+        const float xi = std::floor(x);
+        const float f = x - xi;
+        float p = 1.f + f * (0.69301856f + f * (0.24140525f + f * (0.052072970f + f * 0.013494054f)));
+        std::int32_t bits;
+        std::memcpy(&bits, &p, sizeof(bits));
+        bits += (std::int32_t) xi << 23;
+        std::memcpy(&p, &bits, sizeof(p));
+        return p;
+    }
+
+    float fast_pow(const float x, const float p) {
+        return x <= 0.f ? 0.f : fast_exp2(p * fast_log2(x));
+    }
+
+    /**
+     * cubic-bezier(x1, y1, x2, y2): curva de (0, 0) a (1, 1) com x1, x2 em [0, 1]
+     *   X(s) = ((ax*s + bx)*s + cx)*s, e o mesmo para Y
+    */
+    typedef struct cubic_bezier_timing {
+        float ax, bx, cx;
+        float ay, by, cy;
+        float table[BZ_CUBIC_BEZIER_TABLE + 1]; // s com X(s) = i / BZ_CUBIC_BEZIER_TABLE
+    } cubic_bezier_timing_t;
+
+    cubic_bezier_timing_t make_cubic_bezier(float x1, const float y1, float x2, const float y2) {
+        x1 = std::clamp(x1, 0.f, 1.f);
+        x2 = std::clamp(x2, 0.f, 1.f);
+        cubic_bezier_timing_t c{};
+        c.cx = 3.f * x1;
+        c.bx = 3.f * (x2 - x1) - c.cx;
+        c.ax = 1.f - c.cx - c.bx;
+        c.cy = 3.f * y1;
+        c.by = 3.f * (y2 - y1) - c.cy;
+        c.ay = 1.f - c.cy - c.by;
+        // Com x1, x2 em [0, 1] X é monotônica: bissecção em double para montar a tabela
+        for (int i = 0; i <= BZ_CUBIC_BEZIER_TABLE; i++) {
+            const double x = (double) i / BZ_CUBIC_BEZIER_TABLE;
+            double lo = 0.0, hi = 1.0;
+            for (int k = 0; k < 40; k++) {
+                const double s = 0.5 * (lo + hi);
+                const double X = ((c.ax * s + c.bx) * s + c.cx) * s;
+                (X < x ? lo : hi) = s;
+            }
+            c.table[i] = (float) (0.5 * (lo + hi));
+        }
+        return c;
+    }
+
+    /**
+     * y para um x em [0, 1]: chute pela tabela e um passo de Newton, sem desvios
+    */
+    float solve_cubic_bezier(const cubic_bezier_timing_t& c, float x) {
+        x = std::clamp(x, 0.f, 1.f);
+        const float f = x * BZ_CUBIC_BEZIER_TABLE;
+        const int i = std::min((int) f, BZ_CUBIC_BEZIER_TABLE - 1);
+        float s = c.table[i] + (c.table[i + 1] - c.table[i]) * (f - i);
+        const float X = ((c.ax * s + c.bx) * s + c.cx) * s - x;
+        const float dX = (3.f * c.ax * s + 2.f * c.bx) * s + c.cx;
+        s -= X / std::max(dX, 1e-6f);
+        return ((c.ay * s + c.by) * s + c.cy) * s;
+    }
+
+    typedef struct easing_library {
+        std::vector<cubic_bezier_timing_t> cubic_beziers;
+    } easing_library_t;
+
+    int add_cubic_bezier(easing_library_t* library, const float x1, const float y1, const float x2, const float y2) {
+        library->cubic_beziers.push_back(make_cubic_bezier(x1, y1, x2, y2));
+        return BZ_EASING_BUILTIN_COUNT + (int) library->cubic_beziers.size() - 1;
+    }
+
+    TBasicFunction easing_function(const int id) {
+        return (TBasicFunction) id;
+    }
+
+    int easing_count(const easing_library_t& library) {
+        return BZ_EASING_BUILTIN_COUNT + (int) library.cubic_beziers.size();
+    }
+
+    /**
+     * Aplica simd a blocos de 4 e scalar ao resto (ou a tudo sem SSE2)
+    */
+    template<typename Simd, typename Scalar>
+    void map_batch(const float* in, float* out, const std::size_t n, Simd simd, Scalar scalar) {
+        std::size_t i = 0;
+        #if defined(__SSE2__)
+            for (; i + 4 <= n; i += 4) {
+                _mm_storeu_ps(out + i, simd(_mm_loadu_ps(in + i)));
+            }
+        #else
+            (void) simd;
+        #endif
+        for (; i < n; i++) {
+            out[i] = scalar(in[i]);
+        }
+    }
+
+    #if defined(__SSE2__)
+        typedef __m128 easing_simd_t;
+        #define BZ_EASING_SIMD(expr) [](const easing_simd_t t) { const __m128 one = _mm_set1_ps(1.f); (void) one; return expr; }
+    #else
+        typedef float easing_simd_t;
+        #define BZ_EASING_SIMD(expr) [](const easing_simd_t t) { return t; }
+    #endif
+
+    /**
+     * out[i] = easing(in[i]) para n valores (in e out podem ser o mesmo vetor)
+    */
+    void ease_batch(const easing_library_t& library, const int easing, const float* in, float* out, const std::size_t n) {
+        assert(easing >= 0 && easing < easing_count(library) && "Id de easing fora da biblioteca!");
+        switch (easing) {
+            case TBasicFunction::Quadratic:
+                map_batch(in, out, n,
+                    BZ_EASING_SIMD(_mm_mul_ps(t, t)),
+                    [](const float t) { return t * t; });
+                return;
+            case TBasicFunction::Cubic:
+                map_batch(in, out, n,
+                    BZ_EASING_SIMD(_mm_mul_ps(_mm_mul_ps(t, t), t)),
+                    [](const float t) { return t * t * t; });
+                return;
+            case TBasicFunction::SquareRoot:
+                map_batch(in, out, n,
+                    BZ_EASING_SIMD(_mm_sqrt_ps(_mm_max_ps(t, _mm_setzero_ps()))),
+                    [](const float t) { return fast_sqrt(t); });
+                return;
+            case TBasicFunction::QuadraticEasyOut:
+                map_batch(in, out, n,
+                    BZ_EASING_SIMD(_mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(one, t), _mm_sub_ps(one, t)))),
+                    [](const float t) { return 1.f - (1.f - t) * (1.f - t); });
+                return;
+            case TBasicFunction::Parabola:
+                map_batch(in, out, n,
+                    BZ_EASING_SIMD(_mm_mul_ps(
+                        _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.f), t), _mm_sub_ps(one, t)),
+                        _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.f), t), _mm_sub_ps(one, t))
+                    )),
+                    [](const float t) { const float u = 4.f * t * (1.f - t); return u * u; });
+                return;
+            default:
+                break;
+        }
+        if (easing >= BZ_EASING_BUILTIN_COUNT) {
+            const cubic_bezier_timing_t& c = library.cubic_beziers[easing - BZ_EASING_BUILTIN_COUNT];
+            for (std::size_t i = 0; i < n; i++) {
+                out[i] = solve_cubic_bezier(c, in[i]);
+            }
+        } else if (in != out) {
+            std::memcpy(out, in, n * sizeof(float));
+        }
+    }
+
+    /**
+     * Um valor só (fora dos laços quentes)
+    */
+    float ease(const easing_library_t& library, const int easing, const float t) {
+        float out;
+        ease_batch(library, easing, &t, &out, 1);
+        return out;
+    }
+
+    /**
+     * Vetores reaproveitados entre frames: só alocam quando a quantidade cresce
+    */
+    typedef struct easing_scratch {
+        std::vector<float> t;
+        std::vector<float> sorted;
+        std::vector<std::uint32_t> ids;
+        std::vector<std::uint32_t> order;
+        std::vector<std::uint32_t> offsets;
+    } easing_scratch_t;
+
+    /**
+     * Atualiza count animações contíguas, cada uma com o seu easing
+    */
+    void animation_update_eased(
+        const easing_library_t& library,
+        bezier_animation_t* animations,
+        const std::size_t count,
+        const float dt,
+        easing_scratch_t* scratch
+    ) {
+        BZ_PROFILE_ZONE("animation_update_eased");
+        const int easings = easing_count(library);
+        scratch->t.resize(count);
+        scratch->sorted.resize(count);
+        scratch->ids.resize(count);
+        scratch->order.resize(count);
+        scratch->offsets.assign(easings + 1, 0);
+        for (std::size_t i = 0; i < count; i++) {
+            bezier_animation_t& a = animations[i];
+            scratch->t[i] = (float) bz::advance_time(&a, dt);
+            const int id = (int) a.t_function;
+            assert(id >= 0 && id < easings);
+            scratch->ids[i] = id;
+            scratch->offsets[id + 1]++;
+        }
+        for (int e = 0; e < easings; e++) {
+            scratch->offsets[e + 1] += scratch->offsets[e];
+        }
+        // Counting sort: os t de cada easing ficam contíguos em sorted
+        for (std::size_t i = 0; i < count; i++) {
+            const std::uint32_t pos = scratch->offsets[scratch->ids[i]]++;
+            scratch->sorted[pos] = scratch->t[i];
+            scratch->order[pos] = i;
+        }
+        std::size_t begin = 0;
+        for (int e = 0; e < easings; e++) {
+            const std::size_t end = scratch->offsets[e];
+            if (end > begin) {
+                ease_batch(library, e, scratch->sorted.data() + begin, scratch->sorted.data() + begin, end - begin);
+            }
+            begin = end;
+        }
+        for (std::size_t pos = 0; pos < count; pos++) {
+            scratch->t[scratch->order[pos]] = scratch->sorted[pos];
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            bezier_animation_t& a = animations[i];
+            a.C = a.fixed.evaluate != NULL
+                ? a.fixed.evaluate(a.fixed.curve, scratch->t[i])
+                : bz::evaluate_curve(a.control_points.data(), a.control_points.size(), scratch->t[i]);
+        }
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
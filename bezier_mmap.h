@@ -0,0 +1,80 @@
+#ifndef BEZIER_MMAP_H
+#define BEZIER_MMAP_H
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+/**
+ * Arquivo só de leitura mapeado na memória (padrões, traces). No Windows o
+ * arquivo é lido inteiro para um buffer (o windows.h conflita com os nomes
+ * do raylib).
+*/
+namespace bz {
+
+
+    bool map_file(const char* path, void** data, std::size_t* size) {
+        *data = NULL;
+        *size = 0;
+        #if defined(_WIN32)
+            FILE* file = std::fopen(path, "rb");
+            if (file == NULL) {
+                return false;
+            }
+            std::fseek(file, 0, SEEK_END);
+            const long length = std::ftell(file);
+            std::fseek(file, 0, SEEK_SET);
+            void* buffer = length > 0 ? std::malloc(length) : NULL;
+            const bool read = buffer != NULL && std::fread(buffer, 1, length, file) == (std::size_t) length;
+            std::fclose(file);
+            if (!read) {
+                std::free(buffer);
+                return false;
+            }
+            *data = buffer;
+            *size = length;
+        #else
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                ::close(fd);
+                return false;
+            }
+            void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd); // O mapeamento continua válido sem o descritor
+            if (mapping == MAP_FAILED) {
+                return false;
+            }
+            *data = mapping;
+            *size = st.st_size;
+        #endif
+        return true;
+    }
+
+    void unmap_file(void* data, const std::size_t size) {
+        if (data == NULL) {
+            return;
+        }
+        #if defined(_WIN32)
+            (void) size;
+            std::free(data);
+        #else
+            munmap(data, size);
+        #endif
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef BEZIER_PATTERN_H
+#define BEZIER_PATTERN_H
+#include "bezier.h"
+#include "bezier_mmap.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * Arquivo binário de padrões de bullets: curvas modelo (pontos, duração,
+ * easing) e um cronograma de spawns ordenado por tempo.
+ *
+ * O arquivo é mapeado na memória (bezier_mmap.h) e usado no lugar: os pontos
+ * de controle são lidos direto das páginas do arquivo, sem cópia nem parse,
+ * então fases com centenas de milhares de curvas abrem na hora e processos
+ * diferentes compartilham as mesmas páginas.
+ *
+ * Cronogramas longos são lidos aos poucos por spawn_stream_t.
+ *
+ * Layout (little-endian, tudo alinhado em 4 bytes):
+ *   pattern_header_t
+ *   pattern_curve_t[curve_count]
+ *   Vector2[point_count]
+ *   pattern_spawn_t[spawn_count]    (ordenado por time)
+ *
+ * Formato texto (compilado por BezierPatternCompiler):
+ *   # comentário
+ *   curve <duração> <easing> [loop] : x0 y0 x1 y1 ...
+ *   spawn <tempo> <curva> <x> <y>
+ * As curvas são numeradas na ordem em que aparecem; os pontos são relativos ao
+ * (x, y) do spawn.
+*/
+namespace bz {
+
+
+    #define BZ_PATTERN_MAGIC "BZPT"
+    #define BZ_PATTERN_VERSION 1
+    #define BZ_PATTERN_LOOP 0x1
+
+    typedef struct pattern_header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t curve_count;
+        std::uint32_t point_count;
+        std::uint32_t spawn_count;
+        std::uint32_t reserved;
+        std::uint64_t curves_offset;
+        std::uint64_t points_offset;
+        std::uint64_t spawns_offset;
+    } pattern_header_t;
+
+    typedef struct pattern_curve {
+        std::uint32_t first_point;
+        std::uint32_t point_count;
+        float time_to_complete;
+        std::uint8_t t_function;
+        std::uint8_t flags;      // BZ_PATTERN_LOOP
+        std::uint16_t reserved;
+    } pattern_curve_t;
+
+    typedef struct pattern_spawn {
+        float time;
+        std::uint32_t curve;
+        float x;
+        float y;
+    } pattern_spawn_t;
+
+    static_assert(sizeof(pattern_header_t) == 48, "layout do cabeçalho mudou");
+    static_assert(sizeof(pattern_curve_t) == 16, "layout de pattern_curve_t mudou");
+    static_assert(sizeof(pattern_spawn_t) == 16, "layout de pattern_spawn_t mudou");
+    static_assert(sizeof(Vector2) == 8, "layout de Vector2 mudou");
+
+    /**
+     * Visão do arquivo aberto: os ponteiros apontam para dentro do mapeamento
+    */
+    typedef struct pattern_view {
+        const pattern_header_t* header = NULL;
+        const pattern_curve_t* curves = NULL;
+        const Vector2* points = NULL;
+        const pattern_spawn_t* spawns = NULL;
+        void* data = NULL;     // Início do mapeamento (ou do buffer no Windows)
+        std::size_t size = 0;
+    } pattern_view_t;
+
+    /**
+     * Os pontos de controle da curva, sem cópia
+    */
+    const Vector2* curve_points(const pattern_view_t& view, const std::uint32_t curve) {
+        return view.points + view.curves[curve].first_point;
+    }
+
+    /**
+     * Confere magic, versão, se todas as tabelas cabem no arquivo, as curvas
+     * (pontos dentro da tabela, easing conhecido, duração finita e positiva)
+     * e se os pontos são finitos
+    */
+    bool validate_pattern(const void* data, const std::size_t size) {
+        if (size < sizeof(pattern_header_t)) {
+            return false;
+        }
+        const pattern_header_t* h = (const pattern_header_t*) data;
+        if (std::memcmp(h->magic, BZ_PATTERN_MAGIC, 4) != 0 || h->version != BZ_PATTERN_VERSION) {
+            return false;
+        }
+        const auto fits = [size](const std::uint64_t offset, const std::uint64_t count, const std::size_t item) {
+            return offset % 4 == 0 && offset <= size && count <= (size - offset) / item;
+        };
+        if (!fits(h->curves_offset, h->curve_count, sizeof(pattern_curve_t)) ||
+            !fits(h->points_offset, h->point_count, sizeof(Vector2)) ||
+            !fits(h->spawns_offset, h->spawn_count, sizeof(pattern_spawn_t))) {
+            return false;
+        }
+        const pattern_curve_t* curves = (const pattern_curve_t*) ((const char*) data + h->curves_offset);
+        for (std::uint32_t i = 0; i < h->curve_count; i++) {
+            if (curves[i].point_count < 2 || curves[i].first_point > h->point_count ||
+                curves[i].point_count > h->point_count - curves[i].first_point ||
+                curves[i].t_function > TBasicFunction::Parabola ||
+                !std::isfinite(curves[i].time_to_complete) || curves[i].time_to_complete <= 0.f) {
+                return false;
+            }
+        }
+        const Vector2* points = (const Vector2*) ((const char*) data + h->points_offset);
+        for (std::uint32_t i = 0; i < h->point_count; i++) {
+            if (!std::isfinite(points[i].x) || !std::isfinite(points[i].y)) {
+                return false;
+            }
+        }
+        // Os spawns são conferidos por spawn_stream_t conforme são lidos, para não
+        // trazer o cronograma inteiro para a memória na abertura
+        return true;
+    }
+
+    void close_pattern(pattern_view_t* view) {
+        bz::unmap_file(view->data, view->size);
+        *view = pattern_view_t{};
+    }
+
+    bool open_pattern(const char* path, pattern_view_t* view) {
+        *view = pattern_view_t{};
+        if (!bz::map_file(path, &view->data, &view->size)) {
+            return false;
+        }
+        if (!validate_pattern(view->data, view->size)) {
+            std::fprintf(stderr, "bz::pattern: arquivo inválido: %s\n", path);
+            close_pattern(view);
+            return false;
+        }
+        const char* base = (const char*) view->data;
+        view->header = (const pattern_header_t*) base;
+        view->curves = (const pattern_curve_t*) (base + view->header->curves_offset);
+        view->points = (const Vector2*) (base + view->header->points_offset);
+        view->spawns = (const pattern_spawn_t*) (base + view->header->spawns_offset);
+        #if !defined(_WIN32)
+            madvise(view->data, view->size, MADV_SEQUENTIAL);
+        #endif
+        return true;
+    }
+
+    #define BZ_STREAM_READAHEAD (256 << 10) // Bytes do cronograma pedidos ao kernel à frente do cursor
+
+    /**
+     * Leitura incremental do cronograma de spawns. A cada tick next_spawns
+     * devolve o intervalo de spawns que já venceram (contíguo no arquivo, sem
+     * cópia); as páginas à frente do cursor são pedidas com MADV_WILLNEED e as
+     * que ficaram para trás são devolvidas com MADV_DONTNEED, então a memória
+     * residente não cresce com o tamanho da fase.
+    */
+    typedef struct spawn_stream {
+        const pattern_view_t* view = NULL;
+        std::uint32_t cursor = 0;
+        double time = 0.0;
+        float last_time = -INFINITY;    // Tempo do último spawn lido (a página dele pode já ter sido devolvida)
+        std::size_t advised = 0;  // Offset no arquivo até onde o WILLNEED já foi pedido
+        std::size_t released = 0; // Offset no arquivo até onde as páginas já foram devolvidas
+        bool failed = false;      // Cronograma inválido: o stream para
+    } spawn_stream_t;
+
+    void open_stream(spawn_stream_t* stream, const pattern_view_t* view) {
+        *stream = spawn_stream_t{};
+        stream->view = view;
+        stream->advised = view->header->spawns_offset;
+        stream->released = view->header->spawns_offset;
+    }
+
+    bool stream_finished(const spawn_stream_t& stream) {
+        return stream.failed || stream.cursor >= stream.view->header->spawn_count;
+    }
+
+    void advise_stream(spawn_stream_t* stream) {
+        #if !defined(_WIN32)
+            const std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE);
+            const std::size_t end = stream->view->header->spawns_offset +
+                (std::size_t) stream->view->header->spawn_count * sizeof(pattern_spawn_t);
+            const std::size_t at = stream->view->header->spawns_offset + (std::size_t) stream->cursor * sizeof(pattern_spawn_t);
+            char* base = (char*) stream->view->data;
+            // Janela à frente: pede de uma vez quando metade dela já foi consumida
+            if (stream->advised < end && stream->advised < at + BZ_STREAM_READAHEAD / 2) {
+                const std::size_t from = stream->advised / page * page;
+                const std::size_t to = std::min(end, at + BZ_STREAM_READAHEAD);
+                madvise(base + from, to - from, MADV_WILLNEED);
+                stream->advised = to;
+            }
+            // Devolve em blocos alinhados ao endereço e com um bloco de folga: a falta
+            // de página do kernel também mapeia as vizinhas já em cache (fault-around),
+            // então páginas logo atrás do cursor voltariam sem serem devolvidas de novo
+            const std::size_t block = BZ_STREAM_READAHEAD;
+            const std::uintptr_t address = (std::uintptr_t) base + at;
+            const std::size_t lag = address / block * block - block;
+            const std::size_t behind = lag > (std::uintptr_t) base ? lag - (std::uintptr_t) base : 0;
+            const std::size_t from = (stream->released + page - 1) / page * page;
+            if (behind > from) {
+                madvise(base + from, behind - from, MADV_DONTNEED);
+                stream->released = behind;
+            }
+        #else
+            (void) stream;
+        #endif
+    }
+
+    bool is_valid_spawn(const pattern_spawn_t& spawn, const std::uint32_t curve_count) {
+        return spawn.curve < curve_count &&
+            std::isfinite(spawn.time) && std::isfinite(spawn.x) && std::isfinite(spawn.y);
+    }
+
+    /**
+     * Avança dt e escreve em first/last o intervalo [first, last) de spawns com
+     * time <= tempo atual. Retorna quantos são. O spawn é conferido antes do
+     * tempo: um time NaN nunca passa no <= e pararia o stream sem aviso.
+    */
+    std::uint32_t next_spawns(spawn_stream_t* stream, const float dt, std::uint32_t* first, std::uint32_t* last) {
+        stream->time += dt;
+        *first = stream->cursor;
+        const pattern_view_t& view = *stream->view;
+        const std::uint32_t count = view.header->spawn_count;
+        std::uint32_t i = stream->cursor;
+        for (; !stream->failed && i < count; i++) {
+            const pattern_spawn_t& spawn = view.spawns[i];
+            if (!is_valid_spawn(spawn, view.header->curve_count) || spawn.time < stream->last_time) {
+                std::fprintf(stderr, "bz::pattern: spawn %u inválido, cronograma interrompido\n", i);
+                stream->failed = true;
+                break;
+            }
+            if (spawn.time > stream->time) {
+                break;
+            }
+            stream->last_time = spawn.time;
+        }
+        stream->cursor = i;
+        *last = i;
+        advise_stream(stream);
+        return *last - *first;
+    }
+
+    /**
+     * Padrão em memória, usado pelo compilador
+    */
+    typedef struct pattern_source {
+        std::vector<pattern_curve_t> curves;
+        std::vector<Vector2> points;
+        std::vector<pattern_spawn_t> spawns;
+    } pattern_source_t;
+
+    int easing_from_string(const std::string& name) {
+        const char* names[] = {"Normal", "Quadratic", "Cubic", "SquareRoot", "QuadraticEasyOut", "Parabola"};
+        for (int i = 0; i < 6; i++) {
+            if (name == names[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Lê o formato texto; em erro escreve a linha em stderr e retorna false
+    */
+    bool parse_pattern_text(std::istream& in, pattern_source_t* out) {
+        std::string line;
+        int number = 0;
+        while (std::getline(in, line)) {
+            number++;
+            const std::size_t comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+            std::istringstream ss(line);
+            std::string kind;
+            if (!(ss >> kind)) {
+                continue;
+            }
+            bool ok = false;
+            if (kind == "curve") {
+                pattern_curve_t curve{};
+                std::string easing, token;
+                ss >> curve.time_to_complete >> easing;
+                const int f = easing_from_string(easing);
+                bool flags_ok = true;
+                while (ss >> token && token != ":") {
+                    if (token == "loop") {
+                        curve.flags |= BZ_PATTERN_LOOP;
+                    } else {
+                        flags_ok = false; // Token desconhecido (ex.: "lop")
+                    }
+                }
+                curve.first_point = out->points.size();
+                Vector2 p;
+                bool points_ok = true;
+                while (ss >> p.x >> p.y) {
+                    points_ok = points_ok && std::isfinite(p.x) && std::isfinite(p.y);
+                    out->points.push_back(p);
+                }
+                curve.point_count = out->points.size() - curve.first_point;
+                curve.t_function = (std::uint8_t) f;
+                ok = f >= 0 && flags_ok && points_ok && token == ":" && std::isfinite(curve.time_to_complete) &&
+                    curve.time_to_complete > 0.f && curve.point_count >= 2 && ss.eof();
+                out->curves.push_back(curve);
+            } else if (kind == "spawn") {
+                pattern_spawn_t spawn{};
+                ok = (ss >> spawn.time >> spawn.curve >> spawn.x >> spawn.y) && (ss >> std::ws).eof() &&
+                    std::isfinite(spawn.time) && std::isfinite(spawn.x) && std::isfinite(spawn.y);
+                out->spawns.push_back(spawn);
+            }
+            if (!ok) {
+                std::fprintf(stderr, "bz::pattern: linha %d inválida: %s\n", number, line.c_str());
+                return false;
+            }
+        }
+        for (const pattern_spawn_t& spawn : out->spawns) {
+            if (spawn.curve >= out->curves.size()) {
+                std::fprintf(stderr, "bz::pattern: spawn usa a curva %u, que não existe\n", spawn.curve);
+                return false;
+            }
+        }
+        std::stable_sort(
+            out->spawns.begin(), out->spawns.end(),
+            [](const pattern_spawn_t& l, const pattern_spawn_t& r) { return l.time < r.time; }
+        );
+        return true;
+    }
+
+    bool write_pattern(const pattern_source_t& source, const char* path) {
+        pattern_header_t header{};
+        std::memcpy(header.magic, BZ_PATTERN_MAGIC, 4);
+        header.version = BZ_PATTERN_VERSION;
+        header.curve_count = source.curves.size();
+        header.point_count = source.points.size();
+        header.spawn_count = source.spawns.size();
+        header.curves_offset = sizeof(pattern_header_t);
+        header.points_offset = header.curves_offset + source.curves.size() * sizeof(pattern_curve_t);
+        header.spawns_offset = header.points_offset + source.points.size() * sizeof(Vector2);
+        FILE* file = std::fopen(path, "wb");
+        if (file == NULL) {
+            return false;
+        }
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && std::fwrite(source.curves.data(), sizeof(pattern_curve_t), source.curves.size(), file) == source.curves.size();
+        ok = ok && std::fwrite(source.points.data(), sizeof(Vector2), source.points.size(), file) == source.points.size();
+        ok = ok && std::fwrite(source.spawns.data(), sizeof(pattern_spawn_t), source.spawns.size(), file) == source.spawns.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef BEZIER_POWER_H
+#define BEZIER_POWER_H
+#include "bezier.h"
+#include <algorithm>
+#include <cmath>
+
+
+/**
+ * Curvas pré-compiladas na base de potências (monômios).
+ *
+ * Para curvas cujos pontos de controle não mudam depois de criadas, a conversão
+ * B(t) = sum C(n,k) t^k (1-t)^(n-k) P_k  ->  B(t) = sum a_j t^j
+ * é feita uma vez; cada avaliação fica em n FMAs por coordenada (Horner).
+ * A base de potências é mal condicionada em graus altos, então a compilação
+ * compara com de Casteljau em alguns t e, se o erro passar de
+ * BZ_POWER_TOLERANCE, guarda os pontos e avalia por de Casteljau.
+*/
+namespace bz {
+
+
+    #define BZ_POWER_MAX_DEGREE 7
+    #define BZ_POWER_TOLERANCE 1e-2 // Erro máximo aceito, em unidades do mundo (pixels)
+    #define BZ_POWER_CHECK_SAMPLES 16
+
+    typedef struct power_curve {
+        Vector2 v[BZ_POWER_MAX_DEGREE + 1]; // Coeficientes a_j (power) ou pontos de controle
+        int degree = 0;
+        bool power = false;
+    } power_curve_t;
+
+    /**
+     * Algoritmo de de Casteljau em double: estável para qualquer grau
+    */
+    Vector2 de_casteljau(const Vector2* points, const int count, const double t) {
+        double x[BZ_POWER_MAX_DEGREE + 1], y[BZ_POWER_MAX_DEGREE + 1];
+        assert(count > 0 && count <= BZ_POWER_MAX_DEGREE + 1);
+        for (int i = 0; i < count; i++) {
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+        }
+        for (int r = count - 1; r > 0; r--) {
+            for (int i = 0; i < r; i++) {
+                x[i] += (x[i + 1] - x[i]) * t;
+                y[i] += (y[i + 1] - y[i]) * t;
+            }
+        }
+        return {(float) x[0], (float) y[0]};
+    }
+
+    /**
+     * x*y + z: FMA de hardware quando o alvo tem (ex.: -mfma), senão mult + soma,
+     * já que o std::fma em software é bem mais lento que a conta separada
+    */
+    float fmadd(const float x, const float y, const float z) {
+        #if defined(FP_FAST_FMAF)
+            return std::fma(x, y, z);
+        #else
+            return x * y + z;
+        #endif
+    }
+
+    Vector2 evaluate_power_curve(const power_curve_t& curve, const float t) {
+        if (!curve.power) {
+            return de_casteljau(curve.v, curve.degree + 1, t);
+        }
+        const Vector2* a = curve.v;
+        float x = a[curve.degree].x;
+        float y = a[curve.degree].y;
+        for (int j = curve.degree - 1; j >= 0; j--) {
+            x = fmadd(x, t, a[j].x);
+            y = fmadd(y, t, a[j].y);
+        }
+        return {x, y};
+    }
+
+    /**
+     * Converte os pontos de controle para a base de potências:
+     *   a_j = C(n,j) * sum_{i=0..j} (-1)^(j-i) C(j,i) P_i
+     * x e y precisam de espaço para count coeficientes.
+    */
+    void power_coefficients(const Vector2* points, const int count, double* x, double* y) {
+        const int n = count - 1;
+        for (int j = 0; j <= n; j++) {
+            x[j] = 0.0;
+            y[j] = 0.0;
+            for (int i = 0; i <= j; i++) {
+                const double c = binomial_coefficient(j, i) * ((j - i) % 2 == 0 ? 1.0 : -1.0);
+                x[j] += c * points[i].x;
+                y[j] += c * points[i].y;
+            }
+            const double b = binomial_coefficient(n, j);
+            x[j] *= b;
+            y[j] *= b;
+        }
+    }
+
+    /**
+     * Retorna false se o grau passar de BZ_POWER_MAX_DEGREE (use bezier_animation_t).
+    */
+    bool compile_power_curve(const Vector2* points, const int count, power_curve_t* out) {
+        const int n = count - 1;
+        if (n < 0 || n > BZ_POWER_MAX_DEGREE) {
+            return false;
+        }
+        out->degree = n;
+        out->power = true;
+        double x[BZ_POWER_MAX_DEGREE + 1], y[BZ_POWER_MAX_DEGREE + 1];
+        power_coefficients(points, count, x, y);
+        for (int j = 0; j <= n; j++) {
+            out->v[j] = {(float) x[j], (float) y[j]};
+        }
+        // Checa o condicionamento contra de Casteljau
+        for (int s = 0; s <= BZ_POWER_CHECK_SAMPLES; s++) {
+            const float t = (float) s / BZ_POWER_CHECK_SAMPLES;
+            const Vector2 expected = de_casteljau(points, count, t);
+            const Vector2 got = evaluate_power_curve(*out, t);
+            if (std::fabs(expected.x - got.x) > BZ_POWER_TOLERANCE ||
+                std::fabs(expected.y - got.y) > BZ_POWER_TOLERANCE) {
+                out->power = false;
+                break;
+            }
+        }
+        if (!out->power) {
+            for (int i = 0; i < count; i++) {
+                out->v[i] = points[i];
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Coeficientes de potência dos easings polinomiais; retorna o grau ou -1
+     * se o easing não for polinômio (SquareRoot)
+    */
+    int easing_polynomial(const TBasicFunction f, double* e) {
+        for (int i = 0; i <= 4; i++) {
+            e[i] = 0.0;
+        }
+        switch (f) {
+            case TBasicFunction::Normal:
+                e[1] = 1.0;
+                return 1;
+            case TBasicFunction::Quadratic:
+                e[2] = 1.0;
+                return 2;
+            case TBasicFunction::Cubic:
+                e[3] = 1.0;
+                return 3;
+            case TBasicFunction::QuadraticEasyOut:
+                e[1] = 2.0;
+                e[2] = -1.0;
+                return 2;
+            case TBasicFunction::Parabola:
+                // (4t(1 - t))^2 = 16t^2 - 32t^3 + 16t^4
+                e[2] = 16.0;
+                e[3] = -32.0;
+                e[4] = 16.0;
+                return 4;
+            default:
+                break;
+        }
+        return -1;
+    }
+
+    /**
+     * Compila B(e(t)) como um único polinômio em t (Horner em polinômios:
+     * P = a_n; P = P*e + a_j). Retorna false se o easing não for polinomial, se o
+     * grau composto passar de BZ_POWER_MAX_DEGREE ou se o erro contra a avaliação
+     * separada passar de BZ_POWER_TOLERANCE.
+    */
+    bool compose_power_curve(const Vector2* points, const int count, const TBasicFunction f, power_curve_t* out) {
+        const int n = count - 1;
+        double e[5];
+        const int m = easing_polynomial(f, e);
+        if (n < 1 || m < 1 || n * m > BZ_POWER_MAX_DEGREE) {
+            return false;
+        }
+        double a[2][BZ_POWER_MAX_DEGREE + 1];
+        power_coefficients(points, count, a[0], a[1]);
+        double p[2][BZ_POWER_MAX_DEGREE + 1] = {};
+        int degree = 0;
+        p[0][0] = a[0][n];
+        p[1][0] = a[1][n];
+        for (int j = n - 1; j >= 0; j--) {
+            double r[2][BZ_POWER_MAX_DEGREE + 1] = {};
+            for (int c = 0; c < 2; c++) {
+                for (int i = 0; i <= degree; i++) {
+                    for (int k = 0; k <= m; k++) {
+                        r[c][i + k] += p[c][i] * e[k];
+                    }
+                }
+                r[c][0] += a[c][j];
+            }
+            degree += m;
+            for (int c = 0; c < 2; c++) {
+                for (int i = 0; i <= degree; i++) {
+                    p[c][i] = r[c][i];
+                }
+            }
+        }
+        power_curve_t composed{};
+        composed.degree = degree;
+        composed.power = true;
+        for (int i = 0; i <= degree; i++) {
+            composed.v[i] = {(float) p[0][i], (float) p[1][i]};
+        }
+        for (int s = 0; s <= BZ_POWER_CHECK_SAMPLES; s++) {
+            const float t = (float) s / BZ_POWER_CHECK_SAMPLES;
+            const Vector2 expected = de_casteljau(points, count, bz::apply_t_function(f, t));
+            const Vector2 got = evaluate_power_curve(composed, t);
+            if (std::fabs(expected.x - got.x) > BZ_POWER_TOLERANCE ||
+                std::fabs(expected.y - got.y) > BZ_POWER_TOLERANCE) {
+                return false;
+            }
+        }
+        *out = composed;
+        return true;
+    }
+
+    /**
+     * Animação com a curva compilada guardada no próprio objeto (sem heap).
+     * Os pontos de controle não podem mudar depois de compile_animation.
+    */
+    typedef struct compiled_animation : animation_state {
+        power_curve_t curve;
+    } compiled_animation_t;
+
+    /**
+     * Com compose, um easing polinomial vai para dentro da curva e a t_function
+     * da animação vira Normal. Só compensa quando o lote mistura easings: aí o
+     * switch de apply_t_function erra a previsão a cada bullet. Com um easing
+     * só, o Horner mais longo perde para o easing separado em qualquer grau
+     * (benchmark "compose").
+    */
+    bool compile_animation(
+        const Vector2* points,
+        const int count,
+        compiled_animation_t* animation,
+        const bool compose = false
+    ) {
+        if (compose && animation->t_function != TBasicFunction::Normal &&
+            bz::compose_power_curve(points, count, animation->t_function, &animation->curve)) {
+            animation->t_function = TBasicFunction::Normal;
+            return true;
+        }
+        return bz::compile_power_curve(points, count, &animation->curve);
+    }
+
+    void animation_update(compiled_animation_t* animation, const float dt) {
+        BZ_PROFILE_ZONE("compiled_animation_update");
+        const double t = bz::update_progress(animation, dt);
+        animation->C = bz::evaluate_power_curve(animation->curve, (float) t);
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef BEZIER_PROFILE_H
+#define BEZIER_PROFILE_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+
+/**
+ * Zonas de tempo para os trechos quentes (BZ_PROFILE_ZONE).
+ * Só existem quando compilado com BZ_PROFILE; sem ele a macro vira ((void) 0).
+ *
+ * Cada thread escreve em seu próprio ring buffer (um produtor, sem locks);
+ * os eventos mais antigos são sobrescritos quando o ring enche.
+ * write_chrome_trace() gera um JSON no formato trace_event do Chrome
+ * (chrome://tracing ou ui.perfetto.dev) e deve ser chamado entre frames.
+*/
+#if defined(BZ_PROFILE)
+    #define BZ_PROFILE_CONCAT_(a, b) a##b
+    #define BZ_PROFILE_CONCAT(a, b) BZ_PROFILE_CONCAT_(a, b)
+    #define BZ_PROFILE_ZONE(name) bz::profile::zone_t BZ_PROFILE_CONCAT(bz_profile_zone_, __LINE__)(name)
+#else
+    #define BZ_PROFILE_ZONE(name) ((void) 0)
+#endif
+
+#ifndef BZ_PROFILE_RING_SIZE
+    #define BZ_PROFILE_RING_SIZE (1 << 16) // Eventos por thread, potência de 2
+#endif
+
+
+namespace bz {
+
+namespace profile {
+
+
+#if defined(BZ_PROFILE)
+
+    static_assert((BZ_PROFILE_RING_SIZE & (BZ_PROFILE_RING_SIZE - 1)) == 0, "BZ_PROFILE_RING_SIZE deve ser potência de 2");
+
+    typedef struct event {
+        const char* name; // Literal: o ponteiro precisa viver até o dump
+        std::int64_t begin;
+        std::int64_t end;
+    } event_t;
+
+    typedef struct ring {
+        event_t events[BZ_PROFILE_RING_SIZE];
+        std::atomic<std::uint64_t> head{0};
+        int tid = 0;
+        ring* next = NULL;
+    } ring_t;
+
+    std::atomic<ring_t*> rings{NULL};
+    std::atomic<int> thread_count{0};
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch
+        ).count();
+    }
+
+    /**
+     * Ring da thread atual. É criado no primeiro uso e registrado numa lista
+     * ligada com CAS; nunca é liberado, para que o dump funcione mesmo depois
+     * que a thread terminar.
+    */
+    ring_t* thread_ring() {
+        thread_local ring_t* ring = NULL;
+        if (ring == NULL) {
+            ring = new ring_t();
+            ring->tid = thread_count.fetch_add(1, std::memory_order_relaxed);
+            ring->next = rings.load(std::memory_order_relaxed);
+            while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+        return ring;
+    }
+
+    void record(const char* name, const std::int64_t begin, const std::int64_t end) {
+        ring_t* ring = thread_ring();
+        const std::uint64_t h = ring->head.load(std::memory_order_relaxed);
+        ring->events[h & (BZ_PROFILE_RING_SIZE - 1)] = {name, begin, end};
+        ring->head.store(h + 1, std::memory_order_release);
+    }
+
+    typedef struct zone {
+        const char* name;
+        std::int64_t begin;
+        explicit zone(const char* name) : name(name), begin(now_ns()) { }
+        ~zone() {
+            record(name, begin, now_ns());
+        }
+        zone(const zone&) = delete;
+        zone& operator=(const zone&) = delete;
+    } zone_t;
+
+    void write_json_string(FILE* file, const char* s) {
+        std::fputc('"', file);
+        for (; *s != '\0'; s++) {
+            if (*s == '"' || *s == '\\') {
+                std::fputc('\\', file);
+            }
+            std::fputc(*s, file);
+        }
+        std::fputc('"', file);
+    }
+
+    /**
+     * Grava todos os eventos ainda presentes nos rings como eventos completos ("ph":"X")
+    */
+    bool write_chrome_trace(const char* path) {
+        FILE* file = std::fopen(path, "w");
+        if (file == NULL) {
+            return false;
+        }
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        bool first = true;
+        for (ring_t* ring = rings.load(std::memory_order_acquire); ring != NULL; ring = ring->next) {
+            const std::uint64_t head = ring->head.load(std::memory_order_acquire);
+            const std::uint64_t tail = head > BZ_PROFILE_RING_SIZE ? head - BZ_PROFILE_RING_SIZE : 0;
+            for (std::uint64_t i = tail; i < head; i++) {
+                const event_t& e = ring->events[i & (BZ_PROFILE_RING_SIZE - 1)];
+                std::fprintf(file, first ? "\n{\"name\":" : ",\n{\"name\":");
+                write_json_string(file, e.name);
+                std::fprintf(
+                    file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    ring->tid, e.begin / 1000.0, (e.end - e.begin) / 1000.0
+                );
+                first = false;
+            }
+        }
+        std::fprintf(file, "\n]}\n");
+        std::fclose(file);
+        return true;
+    }
+
+#else
+
+    bool write_chrome_trace(const char* path) {
+        (void) path;
+        std::fprintf(stderr, "bz::profile: compilado sem BZ_PROFILE, nenhum trace gravado\n");
+        return false;
+    }
+
+#endif
+
+
+}  // namespace profile
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef BEZIER_QUANTIZED_H
+#define BEZIER_QUANTIZED_H
+#include "bezier.h"
+#include "bezier_bake.h"
+#include "bezier_template.h"
+#include <cstdint>
+#include <vector>
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+
+/**
+ * Caminhos amostrados em formato compacto: cada amostra é guardada como o
+ * deslocamento em ponto fixo de 16 bits a partir do canto da caixa envolvente
+ * do caminho (4 bytes por amostra em vez dos 8 de um Vector2).
+ * O erro de quantização é no máximo metade de (tamanho da caixa / 65535),
+ * ~0.01 px para um caminho do tamanho da tela.
+ *
+ * Todas as amostras de todos os caminhos ficam num único vetor, então dezenas
+ * de milhares de caminhos cabem contíguos no L2/L3. A decodificação usa SSE2
+ * quando disponível.
+*/
+namespace bz {
+
+
+    #define BZ_QUANTIZED_MAX 65535.f
+
+    typedef struct quantized_path {
+        std::uint32_t offset = 0; // Índice da primeira amostra em quantized_library_t::data (x, y intercalados)
+        std::uint32_t count = 0;  // Quantidade de amostras
+        Vector2 min = {0.f, 0.f}; // Canto da caixa envolvente
+        Vector2 scale = {0.f, 0.f}; // Tamanho da caixa / BZ_QUANTIZED_MAX
+    } quantized_path_t;
+
+    typedef struct quantized_library {
+        std::vector<std::uint16_t> data;
+        std::vector<quantized_path_t> paths;
+    } quantized_library_t;
+
+    /**
+     * Quantiza count amostras e retorna o id do caminho
+    */
+    int add_quantized_path(quantized_library_t* library, const Vector2* samples, const int count) {
+        assert(count > 1 && "Caminho precisa de pelo menos 2 amostras!");
+        quantized_path_t path{};
+        Vector2 max = samples[0];
+        path.min = samples[0];
+        for (int i = 1; i < count; i++) {
+            path.min = {std::min(path.min.x, samples[i].x), std::min(path.min.y, samples[i].y)};
+            max = {std::max(max.x, samples[i].x), std::max(max.y, samples[i].y)};
+        }
+        path.scale = Vector2Scale(Vector2Subtract(max, path.min), 1.f / BZ_QUANTIZED_MAX);
+        path.offset = library->data.size();
+        path.count = count;
+        for (int i = 0; i < count; i++) {
+            const Vector2 d = Vector2Subtract(samples[i], path.min);
+            library->data.push_back(path.scale.x > 0.f ? (std::uint16_t) (d.x / path.scale.x + 0.5f) : 0);
+            library->data.push_back(path.scale.y > 0.f ? (std::uint16_t) (d.y / path.scale.y + 0.5f) : 0);
+        }
+        library->paths.push_back(path);
+        return (int) library->paths.size() - 1;
+    }
+
+    /**
+     * Quantiza um caminho já amostrado (a interpolação passa a ser linear)
+    */
+    int add_quantized_path(quantized_library_t* library, const baked_path_t& path) {
+        return bz::add_quantized_path(library, path.samples.data(), path.samples.size());
+    }
+
+    /**
+     * Decodifica as amostras [first, first + count) do caminho em out
+    */
+    void decode_quantized_path(
+        const quantized_library_t& library,
+        const int path_id,
+        const int first,
+        const int count,
+        Vector2* out
+    ) {
+        const quantized_path_t& path = library.paths[path_id];
+        const std::uint16_t* q = library.data.data() + path.offset + 2 * first;
+        int i = 0;
+        #if defined(__SSE2__)
+            const __m128 scale = _mm_setr_ps(path.scale.x, path.scale.y, path.scale.x, path.scale.y);
+            const __m128 min = _mm_setr_ps(path.min.x, path.min.y, path.min.x, path.min.y);
+            const __m128i zero = _mm_setzero_si128();
+            // 4 amostras (8 valores de 16 bits) por iteração
+            for (; i + 4 <= count; i += 4) {
+                const __m128i packed = _mm_loadu_si128((const __m128i*) (q + 2 * i));
+                const __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, zero));
+                const __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(packed, zero));
+                _mm_storeu_ps((float*) (out + i), _mm_add_ps(_mm_mul_ps(lo, scale), min));
+                _mm_storeu_ps((float*) (out + i + 2), _mm_add_ps(_mm_mul_ps(hi, scale), min));
+            }
+        #endif
+        for (; i < count; i++) {
+            out[i] = {path.min.x + q[2 * i] * path.scale.x, path.min.y + q[2 * i + 1] * path.scale.y};
+        }
+    }
+
+    /**
+     * Posição no tempo normalizado u (fora de [0, 1] fica no extremo), com
+     * interpolação linear entre as duas amostras vizinhas
+    */
+    Vector2 sample_quantized_path(const quantized_library_t& library, const int path_id, const double u) {
+        const quantized_path_t& path = library.paths[path_id];
+        const int last = (int) path.count - 1;
+        const double x = std::clamp(u, 0.0, 1.0) * last;
+        const int i = std::min((int) x, last - 1);
+        const float f = (float) (x - i);
+        const std::uint16_t* q = library.data.data() + path.offset + 2 * i;
+        #if defined(__SSE2__)
+            // As duas amostras (x0, y0, x1, y1) decodificadas de uma vez
+            const __m128i packed = _mm_loadl_epi64((const __m128i*) q);
+            const __m128 v = _mm_add_ps(
+                _mm_mul_ps(
+                    _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128())),
+                    _mm_setr_ps(path.scale.x, path.scale.y, path.scale.x, path.scale.y)
+                ),
+                _mm_setr_ps(path.min.x, path.min.y, path.min.x, path.min.y)
+            );
+            alignas(16) float s[4];
+            _mm_store_ps(s, v);
+            return {s[0] + (s[2] - s[0]) * f, s[1] + (s[3] - s[1]) * f};
+        #else
+            const Vector2 a = {path.min.x + q[0] * path.scale.x, path.min.y + q[1] * path.scale.y};
+            const Vector2 b = {path.min.x + q[2] * path.scale.x, path.min.y + q[3] * path.scale.y};
+            return Vector2Lerp(a, b, f);
+        #endif
+    }
+
+    /**
+     * Animação sobre um caminho quantizado; como em baked_animation_t a
+     * t_function já está nas amostras
+    */
+    typedef struct quantized_animation : animation_state {
+        int path_id = -1;
+        transform2d_t transform;
+    } quantized_animation_t;
+
+    void animation_update(
+        const quantized_library_t* library,
+        quantized_animation_t* animation,
+        const float dt
+    ) {
+        BZ_PROFILE_ZONE("quantized_animation_update");
+        bz::advance_time(animation, dt);
+        animation->C = transform_point(
+            animation->transform, sample_quantized_path(*library, animation->path_id, animation->t)
+        );
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
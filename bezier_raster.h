@@ -0,0 +1,454 @@
+#ifndef BEZIER_RASTER_H
+#define BEZIER_RASTER_H
+#include "bezier.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+
+/**
+ * Rasterizador em CPU com anti-aliasing por cobertura analítica, para
+ * desenhar curvas e bullets numa Image do raylib sem GPU (servidores,
+ * miniaturas, prévias de padrões).
+ *
+ * Toda forma vira um polígono (círculos e traços são achatados com erro
+ * < BZ_RASTER_TOLERANCE). Cada aresta soma no buffer de acumulação a área
+ * exata que cobre em cada pixel da sua linha; a soma prefixada de cada linha
+ * (SSE2) dá a cobertura de cada pixel. Formas da mesma cor seguidas formam uma
+ * camada, composta de uma vez sobre a imagem, na ordem em que foram desenhadas.
+ *
+ * A imagem é dividida em tiles de BZ_RASTER_TILE pixels; cada polígono é
+ * distribuído para os tiles que a sua caixa toca e os tiles são rasterizados
+ * em paralelo, sem nenhuma sincronização além do contador de tiles.
+*/
+namespace bz {
+
+
+    #define BZ_RASTER_TILE 64
+    #define BZ_RASTER_TOLERANCE 0.1f // Erro máximo do achatamento, em pixels
+
+    typedef struct raster_polygon {
+        std::uint32_t first = 0; // Índice do primeiro vértice em rasterizer_t::points
+        std::uint32_t count = 0;
+        std::uint32_t layer = 0;
+        Vector2 min = {0.f, 0.f}; // Caixa envolvente, preenchida por rasterize
+        Vector2 max = {0.f, 0.f};
+    } raster_polygon_t;
+
+    typedef struct rasterizer {
+        int width = 0;
+        int height = 0;
+        std::vector<Vector2> points;
+        std::vector<raster_polygon_t> polygons;
+        std::vector<Color> layers;                    // Cor de cada camada
+        std::vector<std::vector<std::uint32_t>> bins; // Polígonos de cada tile, em ordem
+        std::vector<std::vector<float>> scratch;      // Acumulação + cobertura, um por thread
+    } rasterizer_t;
+
+    /**
+     * Começa um frame: descarta as formas do anterior (a memória fica)
+    */
+    void begin_raster(rasterizer_t* r, const int width, const int height) {
+        r->width = width;
+        r->height = height;
+        r->points.clear();
+        r->polygons.clear();
+        r->layers.clear();
+    }
+
+    void begin_polygon(rasterizer_t* r, const Color color) {
+        const Color& last = r->layers.empty() ? color : r->layers.back();
+        if (r->layers.empty() || last.r != color.r || last.g != color.g || last.b != color.b || last.a != color.a) {
+            r->layers.push_back(color);
+        }
+        raster_polygon_t polygon{};
+        polygon.first = r->points.size();
+        polygon.layer = r->layers.size() - 1;
+        r->polygons.push_back(polygon);
+    }
+
+    void end_polygon(rasterizer_t* r) {
+        raster_polygon_t& polygon = r->polygons.back();
+        polygon.count = r->points.size() - polygon.first;
+        if (polygon.count < 3) {
+            r->points.resize(polygon.first);
+            r->polygons.pop_back();
+        }
+    }
+
+    /**
+     * Todos os polígonos saem no mesmo sentido: sobreposições da mesma camada
+     * somam cobertura (e são limitadas a 1) em vez de se cancelarem
+    */
+    void raster_circle(rasterizer_t* r, const Vector2 center, const float radius, const Color color) {
+        const float cosine = std::clamp(1.f - BZ_RASTER_TOLERANCE / std::max(radius, BZ_RASTER_TOLERANCE), -1.f, 1.f);
+        const int n = std::clamp((int) std::ceil(PI / std::acos(cosine)), 8, 256);
+        const float c = std::cos(2.f * PI / n), s = std::sin(2.f * PI / n);
+        bz::begin_polygon(r, color);
+        // Vértices um pouco para fora: o polígono fica com a área do círculo
+        float x = radius * std::sqrt(2.f * PI / (n * s)), y = 0.f;
+        for (int i = 0; i < n; i++) {
+            r->points.push_back({center.x + x, center.y + y});
+            const float nx = x * c - y * s;
+            y = x * s + y * c;
+            x = nx;
+        }
+        bz::end_polygon(r);
+    }
+
+    /**
+     * Um quadrilátero por segmento, estendido de meia espessura nas pontas
+     * para cobrir o lado de fora das juntas
+    */
+    void raster_polyline(rasterizer_t* r, const Vector2* points, const int count, const float thickness, const Color color) {
+        const float h = 0.5f * thickness;
+        for (int i = 0; i + 1 < count; i++) {
+            const Vector2 d = Vector2Subtract(points[i + 1], points[i]);
+            const float length = Vector2Length(d);
+            if (length <= 0.f) {
+                continue;
+            }
+            const Vector2 u = Vector2Scale(d, h / length);
+            const Vector2 n = {-u.y, u.x};
+            const Vector2 a = Vector2Subtract(points[i], u);
+            const Vector2 b = Vector2Add(points[i + 1], u);
+            bz::begin_polygon(r, color);
+            r->points.push_back(Vector2Subtract(a, n));
+            r->points.push_back(Vector2Subtract(b, n));
+            r->points.push_back(Vector2Add(b, n));
+            r->points.push_back(Vector2Add(a, n));
+            bz::end_polygon(r);
+        }
+    }
+
+    /**
+     * Traço da curva de Bézier (pontos de controle em points)
+    */
+    void raster_curve(rasterizer_t* r, const Vector2* points, const int count, const float thickness, const Color color) {
+        float hull = 0.f;
+        for (int i = 0; i + 1 < count; i++) {
+            hull += Vector2Distance(points[i], points[i + 1]);
+        }
+        // O comprimento do polígono de controle limita o da curva: ~4 px por segmento
+        const int n = std::clamp((int) (hull / 4.f), 1, 256);
+        Vector2 line[257];
+        for (int i = 0; i <= n; i++) {
+            line[i] = bz::evaluate_curve(points, count, (double) i / n);
+        }
+        bz::raster_polyline(r, line, n + 1, thickness, color);
+    }
+
+    /**
+     * Área de uma aresta (coordenadas do tile, x em [0, w]) em cada pixel das
+     * linhas que ela cruza; a soma prefixada da linha dá a cobertura
+    */
+    void accumulate_edge(float* acc, const int stride, const int w, const int h, Vector2 p0, Vector2 p1) {
+        if (p0.y == p1.y) {
+            return;
+        }
+        float dir = 1.f;
+        if (p0.y > p1.y) {
+            std::swap(p0, p1);
+            dir = -1.f;
+        }
+        const float dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+        float x = p0.x;
+        if (p0.y < 0.f) {
+            x = std::clamp(x - p0.y * dxdy, 0.f, (float) w);
+        }
+        const int y_end = std::min(h, (int) std::ceil(p1.y));
+        for (int y = std::max(0, (int) p0.y); y < y_end; y++) {
+            float* row = acc + y * stride;
+            const float dy = std::min((float) (y + 1), p1.y) - std::max((float) y, p0.y);
+            // Limitado a [0, w] só para o arredondamento não sair do tile
+            const float x_next = std::clamp(x + dxdy * dy, 0.f, (float) w);
+            const float d = dy * dir;
+            const float x0 = std::min(x, x_next), x1 = std::max(x, x_next);
+            // x >= 0: a conversão para int já é o floor (e evita a chamada da libm)
+            const int x0i = (int) x0;
+            const float x0_floor = (float) x0i;
+            const int x1i = (int) x1 + ((float) (int) x1 < x1);
+            const float x1_ceil = (float) x1i;
+            if (x1i <= x0i + 1) {
+                // Dentro de um pixel só: a área é a do trapézio até o meio da aresta
+                const float xm = 0.5f * (x + x_next) - x0_floor;
+                row[x0i] += d - d * xm;
+                row[x0i + 1] += d * xm;
+            } else {
+                const float s = 1.f / (x1 - x0);
+                const float x0f = x0 - x0_floor;
+                const float a0 = 0.5f * s * (1.f - x0f) * (1.f - x0f);
+                const float x1f = x1 - x1_ceil + 1.f;
+                const float am = 0.5f * s * x1f * x1f;
+                row[x0i] += d * a0;
+                if (x1i == x0i + 2) {
+                    row[x0i + 1] += d * (1.f - a0 - am);
+                } else {
+                    const float a1 = s * (1.5f - x0f);
+                    row[x0i + 1] += d * (a1 - a0);
+                    for (int xi = x0i + 2; xi < x1i - 1; xi++) {
+                        row[xi] += d * s;
+                    }
+                    const float a2 = a1 + (x1i - x0i - 3) * s;
+                    row[x1i - 1] += d * (1.f - a2 - am);
+                }
+                row[x1i] += d * am;
+            }
+            x = x_next;
+        }
+    }
+
+    /**
+     * Recorta a aresta em x = 0 e x = w: o que fica à esquerda vira uma aresta
+     * vertical em x = 0 (cobre a linha inteira do tile) e o que fica à direita
+     * não cobre nada do tile
+    */
+    void accumulate_clipped_edge(float* acc, const int stride, const int w, const int h, const Vector2 p0, const Vector2 p1) {
+        if ((p0.y < 0.f && p1.y < 0.f) || (p0.y > h && p1.y > h) || (p0.x >= w && p1.x >= w)) {
+            return;
+        }
+        if (p0.x >= 0.f && p1.x >= 0.f && p0.x <= w && p1.x <= w) {
+            bz::accumulate_edge(acc, stride, w, h, p0, p1);
+            return;
+        }
+        float ts[4] = {0.f, 1.f, 1.f, 1.f};
+        int n = 1;
+        const float dx = p1.x - p0.x;
+        if (dx != 0.f) {
+            for (const float edge : {0.f, (float) w}) {
+                const float t = (edge - p0.x) / dx;
+                if (t > 0.f && t < 1.f) {
+                    ts[n++] = t;
+                }
+            }
+        }
+        ts[n] = 1.f;
+        // No máximo dois cortes: basta ordenar os dois do meio
+        if (n == 3 && ts[1] > ts[2]) {
+            std::swap(ts[1], ts[2]);
+        }
+        for (int i = 0; i < n; i++) {
+            const Vector2 a = Vector2Lerp(p0, p1, ts[i]);
+            const Vector2 b = Vector2Lerp(p0, p1, ts[i + 1]);
+            const float mid = 0.5f * (a.x + b.x);
+            if (mid >= w) {
+                continue;
+            }
+            if (mid <= 0.f) {
+                bz::accumulate_edge(acc, stride, w, h, {0.f, a.y}, {0.f, b.y});
+            } else {
+                bz::accumulate_edge(acc, stride, w, h, {std::clamp(a.x, 0.f, (float) w), a.y}, {std::clamp(b.x, 0.f, (float) w), b.y});
+            }
+        }
+    }
+
+    /**
+     * Soma prefixada das colunas [begin, end) de uma linha (begin múltiplo de
+     * 4, nada acumulado antes dele): cobertura = min(|soma|, 1). Zera a
+     * acumulação no caminho para a próxima camada.
+    */
+    void resolve_row(float* acc, float* coverage, const int begin, const int end) {
+        int x = begin;
+        #if defined(__SSE2__)
+            __m128 carry = _mm_setzero_ps();
+            const __m128 sign = _mm_set1_ps(-0.f);
+            const __m128 one = _mm_set1_ps(1.f);
+            for (; x + 4 <= end; x += 4) {
+                __m128 v = _mm_loadu_ps(acc + x);
+                v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+                v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+                v = _mm_add_ps(v, carry);
+                carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+                _mm_storeu_ps(coverage + x, _mm_min_ps(_mm_andnot_ps(sign, v), one));
+                _mm_storeu_ps(acc + x, _mm_setzero_ps());
+            }
+            float sum = _mm_cvtss_f32(carry);
+        #else
+            float sum = 0.f;
+        #endif
+        for (; x < end; x++) {
+            sum += acc[x];
+            coverage[x] = std::min(std::fabs(sum), 1.f);
+            acc[x] = 0.f;
+        }
+    }
+
+    /**
+     * Região do tile tocada pela camada atual
+    */
+    typedef struct raster_dirty {
+        int x0, y0, x1, y1;
+    } raster_dirty_t;
+
+    /**
+     * x / 255 arredondado, exato para x em [0, 255 * 255]
+    */
+    int div255(const int x) {
+        const int t = x + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    /**
+     * Compõe a camada acumulada na região suja do tile
+    */
+    void composite_layer(
+        float* acc, float* coverage, const int stride, const raster_dirty_t& dirty,
+        Color* pixels, const int pitch, const int w, const Color color
+    ) {
+        const int begin = dirty.x0 & ~3;
+        const int end = std::min(stride, dirty.x1);
+        const int last = std::min(w, end);
+        #if defined(__SSE2__)
+            const __m128 alpha = _mm_set1_ps(color.a);
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i full = _mm_set1_epi16(255);
+            const __m128i round = _mm_set1_epi16(128);
+            // Dois pixels da cor em 16 bits; o canal alfa entra como 255 (out.a = a + dst.a * (255 - a) / 255)
+            const __m128i source = _mm_setr_epi16(color.r, color.g, color.b, 255, color.r, color.g, color.b, 255);
+        #endif
+        for (int y = dirty.y0; y < dirty.y1; y++) {
+            bz::resolve_row(acc + y * stride, coverage, begin, end);
+            Color* out = pixels + y * pitch;
+            int x = begin;
+            #if defined(__SSE2__)
+                // 4 pixels por vez: out = (cor * a + out * (255 - a)) / 255 em 16 bits
+                for (; x + 4 <= last; x += 4) {
+                    const __m128i a32 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(coverage + x), alpha));
+                    const __m128i a16 = _mm_packs_epi32(a32, a32);
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi16(a16, zero)) == 0xffff) {
+                        continue;
+                    }
+                    const __m128i a_pairs = _mm_unpacklo_epi16(a16, a16);
+                    const __m128i a01 = _mm_unpacklo_epi32(a_pairs, a_pairs);
+                    const __m128i a23 = _mm_unpackhi_epi32(a_pairs, a_pairs);
+                    const __m128i dst = _mm_loadu_si128((const __m128i*) (out + x));
+                    __m128i lo = _mm_unpacklo_epi8(dst, zero);
+                    __m128i hi = _mm_unpackhi_epi8(dst, zero);
+                    lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(source, a01), _mm_mullo_epi16(lo, _mm_sub_epi16(full, a01))), round);
+                    hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(source, a23), _mm_mullo_epi16(hi, _mm_sub_epi16(full, a23))), round);
+                    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+                    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+                    _mm_storeu_si128((__m128i*) (out + x), _mm_packus_epi16(lo, hi));
+                }
+            #endif
+            for (; x < last; x++) {
+                const int a = (int) (coverage[x] * color.a + 0.5f);
+                if (a == 0) {
+                    continue;
+                }
+                const int b = 255 - a;
+                out[x].r = (std::uint8_t) bz::div255(color.r * a + out[x].r * b);
+                out[x].g = (std::uint8_t) bz::div255(color.g * a + out[x].g * b);
+                out[x].b = (std::uint8_t) bz::div255(color.b * a + out[x].b * b);
+                out[x].a = (std::uint8_t) bz::div255(255 * a + out[x].a * b);
+            }
+        }
+    }
+
+    void raster_tile(rasterizer_t* r, const int tile, Image* image, std::vector<float>* scratch) {
+        const int tiles_x = (r->width + BZ_RASTER_TILE - 1) / BZ_RASTER_TILE;
+        const int tx = (tile % tiles_x) * BZ_RASTER_TILE;
+        const int ty = (tile / tiles_x) * BZ_RASTER_TILE;
+        const int w = std::min(BZ_RASTER_TILE, r->width - tx);
+        const int h = std::min(BZ_RASTER_TILE, r->height - ty);
+        const int stride = BZ_RASTER_TILE + 4; // Colunas w e w + 1 recebem as sobras das arestas
+        scratch->resize(stride * BZ_RASTER_TILE + stride);
+        float* acc = scratch->data();
+        float* coverage = acc + stride * BZ_RASTER_TILE;
+        Color* pixels = (Color*) image->data + ty * image->width + tx;
+        const std::vector<std::uint32_t>& bin = r->bins[tile];
+        const raster_dirty_t clean = {stride, h, 0, 0};
+        raster_dirty_t dirty = clean;
+        for (std::size_t i = 0; i < bin.size(); i++) {
+            const raster_polygon_t& polygon = r->polygons[bin[i]];
+            const Vector2* p = r->points.data() + polygon.first;
+            Vector2 a = {p[polygon.count - 1].x - tx, p[polygon.count - 1].y - ty};
+            for (std::uint32_t k = 0; k < polygon.count; k++) {
+                const Vector2 b = {p[k].x - tx, p[k].y - ty};
+                bz::accumulate_clipped_edge(acc, stride, w, h, a, b);
+                a = b;
+            }
+            dirty.x0 = std::min(dirty.x0, (int) std::clamp(polygon.min.x - tx, 0.f, (float) w));
+            dirty.x1 = std::max(dirty.x1, (int) std::clamp(polygon.max.x - tx, 0.f, (float) w) + 2);
+            dirty.y0 = std::min(dirty.y0, (int) std::clamp(polygon.min.y - ty, 0.f, (float) h));
+            dirty.y1 = std::max(dirty.y1, (int) std::ceil(std::clamp(polygon.max.y - ty, 0.f, (float) h)));
+            const bool layer_ends = i + 1 == bin.size() || r->polygons[bin[i + 1]].layer != polygon.layer;
+            if (layer_ends) {
+                if (dirty.y1 > dirty.y0) {
+                    bz::composite_layer(acc, coverage, stride, dirty, pixels, image->width, w, r->layers[polygon.layer]);
+                }
+                dirty = clean;
+            }
+        }
+    }
+
+    /**
+     * Desenha as formas do frame em image (RGBA de 8 bits, do tamanho passado
+     * a begin_raster). threads = 0 usa todos os núcleos.
+    */
+    void rasterize(rasterizer_t* r, Image* image, unsigned threads = 0) {
+        BZ_PROFILE_ZONE("rasterize");
+        assert(image->format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 && "Imagem precisa ser RGBA de 8 bits!");
+        assert(image->width == r->width && image->height == r->height);
+        const int tiles_x = (r->width + BZ_RASTER_TILE - 1) / BZ_RASTER_TILE;
+        const int tiles_y = (r->height + BZ_RASTER_TILE - 1) / BZ_RASTER_TILE;
+        r->bins.resize(tiles_x * tiles_y);
+        for (std::vector<std::uint32_t>& bin : r->bins) {
+            bin.clear();
+        }
+        for (std::uint32_t i = 0; i < r->polygons.size(); i++) {
+            raster_polygon_t& polygon = r->polygons[i];
+            Vector2 lo = r->points[polygon.first], hi = lo;
+            for (std::uint32_t k = 1; k < polygon.count; k++) {
+                const Vector2 p = r->points[polygon.first + k];
+                lo = {std::min(lo.x, p.x), std::min(lo.y, p.y)};
+                hi = {std::max(hi.x, p.x), std::max(hi.y, p.y)};
+            }
+            polygon.min = lo;
+            polygon.max = hi;
+            const int x0 = std::max(0, (int) std::floor(lo.x) / BZ_RASTER_TILE);
+            const int y0 = std::max(0, (int) std::floor(lo.y) / BZ_RASTER_TILE);
+            const int x1 = std::min(tiles_x - 1, (int) std::floor(hi.x) / BZ_RASTER_TILE);
+            const int y1 = std::min(tiles_y - 1, (int) std::floor(hi.y) / BZ_RASTER_TILE);
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    r->bins[y * tiles_x + x].push_back(i);
+                }
+            }
+        }
+        const int tiles = tiles_x * tiles_y;
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = (unsigned) std::clamp(tiles, 1, (int) threads);
+        r->scratch.resize(std::max<std::size_t>(r->scratch.size(), threads));
+        std::atomic<int> next{0};
+        const auto work = [&](const unsigned worker) {
+            for (int tile = next++; tile < tiles; tile = next++) {
+                if (!r->bins[tile].empty()) {
+                    bz::raster_tile(r, tile, image, &r->scratch[worker]);
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back(work, i);
+        }
+        work(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,482 @@
+#ifndef BEZIER_SCALAR_H
+#define BEZIER_SCALAR_H
+#include "bezier.h"
+#include "bezier_static.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * Curvas e animações parametrizadas pelo tipo escalar.
+ *
+ * bezier_animation_t mistura double (t, time_count, pesos) com os floats do
+ * Vector2 e converte a cada termo da soma. Aqui tudo é Scalar:
+ *   float    -> metade da memória; o tempo acumulado em float deriva alguns
+ *               pixels ao longo de minutos
+ *   double   -> precisão
+ *   fixed16  -> ponto fixo 16.16, resultado idêntico em qualquer máquina
+ *               (o dt também é quantizado em 1/65536 s, então o tempo anda
+ *               um pouco diferente do caminho em double)
+ * bz::bezier<N, Scalar> (bezier_static.h) também aceita os três.
+ * Em ponto flutuante os graus 1 a 3 têm kernels fixos e os outros usam o laço
+ * de Bernstein com os binomiais pré-calculados. animation_batch guarda
+ * animações do mesmo grau e easing em arrays (SoA) e avalia a curva de todas
+ * em laços que o compilador vetoriza (-O3): é o caminho em que float ganha de
+ * double (benchmark "scalar").
+*/
+namespace bz {
+
+
+    /**
+     * Ponto fixo 16.16 com sinal (faixa de +-32768, passo de 1/65536)
+    */
+    struct fixed16 {
+        std::int32_t raw = 0;
+
+        constexpr fixed16() = default;
+        constexpr fixed16(const int v) : raw(v * 65536) { }
+        explicit constexpr fixed16(const float v) : raw((std::int32_t) (v * 65536.f + (v < 0.f ? -0.5f : 0.5f))) { }
+        explicit constexpr fixed16(const double v) : raw((std::int32_t) (v * 65536.0 + (v < 0.0 ? -0.5 : 0.5))) { }
+
+        static constexpr fixed16 from_raw(const std::int32_t raw) {
+            fixed16 f;
+            f.raw = raw;
+            return f;
+        }
+
+        explicit constexpr operator float() const {
+            return raw / 65536.f;
+        }
+
+        explicit constexpr operator double() const {
+            return raw / 65536.0;
+        }
+
+        constexpr fixed16& operator+=(const fixed16 o) {
+            raw += o.raw;
+            return *this;
+        }
+
+        constexpr fixed16& operator-=(const fixed16 o) {
+            raw -= o.raw;
+            return *this;
+        }
+
+        constexpr fixed16& operator*=(const fixed16 o) {
+            raw = (std::int32_t) (((std::int64_t) raw * o.raw + (1 << 15)) >> 16);
+            return *this;
+        }
+
+        constexpr fixed16& operator/=(const fixed16 o) {
+            raw = (std::int32_t) (((std::int64_t) raw << 16) / o.raw);
+            return *this;
+        }
+    };
+
+    typedef fixed16 fixed16_t;
+
+    constexpr fixed16 operator+(fixed16 l, const fixed16 r) { return l += r; }
+    constexpr fixed16 operator-(fixed16 l, const fixed16 r) { return l -= r; }
+    constexpr fixed16 operator*(fixed16 l, const fixed16 r) { return l *= r; }
+    constexpr fixed16 operator/(fixed16 l, const fixed16 r) { return l /= r; }
+    constexpr fixed16 operator-(const fixed16 v) { return fixed16::from_raw(-v.raw); }
+    constexpr bool operator==(const fixed16 l, const fixed16 r) { return l.raw == r.raw; }
+    constexpr bool operator<(const fixed16 l, const fixed16 r) { return l.raw < r.raw; }
+    constexpr bool operator>(const fixed16 l, const fixed16 r) { return l.raw > r.raw; }
+    constexpr bool operator<=(const fixed16 l, const fixed16 r) { return l.raw <= r.raw; }
+    constexpr bool operator>=(const fixed16 l, const fixed16 r) { return l.raw >= r.raw; }
+
+    /**
+     * Raiz quadrada inteira (bit a bit) de raw << 16: exata e determinística
+    */
+    constexpr fixed16 sqrt(const fixed16 v) {
+        if (v.raw <= 0) {
+            return fixed16{};
+        }
+        std::uint64_t x = (std::uint64_t) v.raw << 16;
+        std::uint64_t result = 0;
+        std::uint64_t bit = (std::uint64_t) 1 << 62;
+        while (bit > x) {
+            bit >>= 2;
+        }
+        while (bit != 0) {
+            if (x >= result + bit) {
+                x -= result + bit;
+                result = (result >> 1) + bit;
+            } else {
+                result >>= 1;
+            }
+            bit >>= 2;
+        }
+        return fixed16::from_raw((std::int32_t) result);
+    }
+
+    template<typename Scalar>
+    Scalar apply_t_function(const TBasicFunction f, const Scalar t) {
+        using std::sqrt;
+        const Scalar one = Scalar(1);
+        switch (f) {
+            case TBasicFunction::Quadratic:
+                return t * t;
+            case TBasicFunction::Cubic:
+                return t * t * t;
+            case TBasicFunction::SquareRoot:
+                return sqrt(t);
+            case TBasicFunction::QuadraticEasyOut:
+                return one - (one - t) * (one - t);
+            case TBasicFunction::Parabola: {
+                const Scalar u = Scalar(4) * t * (one - t);
+                return u * u;
+            }
+            default:
+                assert(f == TBasicFunction::Normal && "Id de cubic-bezier: use animation_update_eased (bezier_easing.h)!");
+                break;
+        }
+        return t;
+    }
+
+    template<typename Scalar>
+    struct basic_animation {
+        std::vector<point<Scalar>> control_points;
+        point<Scalar> C{};
+        Scalar time_count = Scalar(0);
+        Scalar time_to_complete = Scalar(1);
+        Scalar t = Scalar(0);
+        bool reverse = false;
+        bool loop = false;
+        TBasicFunction t_function = TBasicFunction::Normal;
+    };
+
+    typedef basic_animation<float> animation_f;
+    typedef basic_animation<double> animation_d;
+    typedef basic_animation<fixed16_t> animation_x;
+
+    /**
+     * Cópia de uma bezier_animation_t no tipo Scalar
+    */
+    template<typename Scalar>
+    basic_animation<Scalar> to_scalar(const bezier_animation_t& animation) {
+        basic_animation<Scalar> out;
+        for (const Vector2 p : animation.control_points) {
+            out.control_points.push_back({Scalar(p.x), Scalar(p.y)});
+        }
+        out.C = {Scalar(animation.C.x), Scalar(animation.C.y)};
+        out.time_count = Scalar(animation.time_count);
+        out.time_to_complete = Scalar(animation.time_to_complete);
+        out.t = Scalar(animation.t);
+        out.reverse = animation.reverse;
+        out.loop = animation.loop;
+        out.t_function = animation.t_function;
+        return out;
+    }
+
+    template<typename Scalar>
+    Scalar update_progress(basic_animation<Scalar>* animation, const Scalar dt) {
+        const Scalar one = Scalar(1);
+        animation->time_count += dt;
+        animation->t = animation->time_count / animation->time_to_complete;
+        animation->t = animation->reverse ? one - animation->t : animation->t;
+        if (animation->loop && (animation->t > one || animation->t < Scalar(0))) {
+            animation->reverse = !animation->reverse;
+            animation->time_count = Scalar(0);
+        }
+        return bz::apply_t_function(animation->t_function, animation->t);
+    }
+
+    #define BZ_SCALAR_MAX_DEGREE 31
+
+    /**
+     * Triângulo de Pascal até BZ_SCALAR_MAX_DEGREE, calculado no build
+    */
+    template<typename Scalar>
+    struct binomial_table {
+        Scalar c[BZ_SCALAR_MAX_DEGREE + 1][BZ_SCALAR_MAX_DEGREE + 1] = {};
+
+        constexpr binomial_table() {
+            for (int n = 0; n <= BZ_SCALAR_MAX_DEGREE; n++) {
+                c[n][0] = Scalar(1);
+                for (int k = 1; k <= n; k++) {
+                    c[n][k] = c[n - 1][k - 1] + (k < n ? c[n - 1][k] : Scalar(0));
+                }
+            }
+        }
+    };
+
+    template<typename Scalar>
+    inline constexpr binomial_table<Scalar> scalar_binomials{};
+
+    /**
+     * Em ponto flutuante usa kernels fixos até o grau 3 e depois a soma de
+     * Bernstein com as potências acumuladas; em ponto fixo usa de Casteljau,
+     * que só interpola entre pontos e não perde as potências pequenas de t
+     * para o arredondamento
+    */
+    template<typename Scalar>
+    point<Scalar> evaluate_curve(const point<Scalar>* points, const int count, const Scalar t) {
+        assert(count > 0 && count <= BZ_SCALAR_MAX_DEGREE + 1);
+        const int n = count - 1;
+        const Scalar s = Scalar(1) - t;
+        if constexpr (std::is_floating_point_v<Scalar>) {
+            const point<Scalar>* p = points;
+            switch (count) {
+                case 1:
+                    return p[0];
+                case 2:
+                    return {s * p[0].x + t * p[1].x, s * p[0].y + t * p[1].y};
+                case 3: {
+                    const Scalar b0 = s * s, b1 = Scalar(2) * s * t, b2 = t * t;
+                    return {b0 * p[0].x + b1 * p[1].x + b2 * p[2].x, b0 * p[0].y + b1 * p[1].y + b2 * p[2].y};
+                }
+                case 4: {
+                    const Scalar b0 = s * s * s, b1 = Scalar(3) * s * s * t, b2 = Scalar(3) * s * t * t, b3 = t * t * t;
+                    return {
+                        b0 * p[0].x + b1 * p[1].x + b2 * p[2].x + b3 * p[3].x,
+                        b0 * p[0].y + b1 * p[1].y + b2 * p[2].y + b3 * p[3].y
+                    };
+                }
+                default:
+                    break;
+            }
+            const Scalar* binomials = scalar_binomials<Scalar>.c[n];
+            Scalar sk[BZ_SCALAR_MAX_DEGREE + 1];
+            sk[0] = Scalar(1);
+            for (int k = 1; k <= n; k++) {
+                sk[k] = sk[k - 1] * s;
+            }
+            Scalar x = Scalar(0), y = Scalar(0), tk = Scalar(1);
+            for (int k = 0; k <= n; k++) {
+                const Scalar w = binomials[k] * tk * sk[n - k];
+                x += w * points[k].x;
+                y += w * points[k].y;
+                tk *= t;
+            }
+            return {x, y};
+        } else {
+            point<Scalar> p[BZ_SCALAR_MAX_DEGREE + 1];
+            for (int i = 0; i < count; i++) {
+                p[i] = points[i];
+            }
+            for (int r = n; r > 0; r--) {
+                for (int i = 0; i < r; i++) {
+                    p[i] = {p[i].x * s + p[i + 1].x * t, p[i].y * s + p[i + 1].y * t};
+                }
+            }
+            return p[0];
+        }
+    }
+
+    template<typename Scalar>
+    void animation_update(basic_animation<Scalar>* animation, const Scalar dt) {
+        const Scalar t = bz::update_progress(animation, dt);
+        animation->C = bz::evaluate_curve(animation->control_points.data(), animation->control_points.size(), t);
+    }
+
+    /**
+     * Atualiza count animações contíguas
+    */
+    template<typename Scalar>
+    void animation_update(basic_animation<Scalar>* animations, const std::size_t count, const Scalar dt) {
+        BZ_PROFILE_ZONE("scalar_animation_update");
+        for (std::size_t i = 0; i < count; i++) {
+            bz::animation_update(&animations[i], dt);
+        }
+    }
+
+    #define BZ_BATCH_REVERSE 1
+    #define BZ_BATCH_LOOP 2
+
+    /**
+     * Animações com o mesmo número de pontos e o mesmo easing em estrutura de
+     * arrays. O ponto k da animação i fica em x[k * size + i] / y[k * size + i];
+     * o t antes do easing não é guardado (sai de time_count a cada frame).
+    */
+    template<typename Scalar>
+    struct animation_batch {
+        static_assert(std::is_floating_point_v<Scalar>, "animation_batch é só para float e double");
+        int count = 0;
+        TBasicFunction t_function = TBasicFunction::Normal;
+        std::vector<Scalar> x, y;
+        std::vector<Scalar> cx, cy; // Ponto C de cada animação
+        std::vector<Scalar> time_count, time_to_complete;
+        std::vector<std::uint8_t> flags; // BZ_BATCH_REVERSE | BZ_BATCH_LOOP
+
+        std::size_t size() const {
+            return time_count.size();
+        }
+    };
+
+    typedef animation_batch<float> animation_batch_f;
+    typedef animation_batch<double> animation_batch_d;
+
+    /**
+     * Copia animações de mesmo grau e mesmo easing para o lote
+    */
+    template<typename Scalar>
+    void to_batch(const basic_animation<Scalar>* animations, const std::size_t size, animation_batch<Scalar>* out) {
+        assert(size > 0 && "Lote vazio!");
+        const int count = (int) animations[0].control_points.size();
+        out->count = count;
+        out->t_function = animations[0].t_function;
+        out->x.resize(count * size);
+        out->y.resize(count * size);
+        out->cx.resize(size);
+        out->cy.resize(size);
+        out->time_count.resize(size);
+        out->time_to_complete.resize(size);
+        out->flags.resize(size);
+        for (std::size_t i = 0; i < size; i++) {
+            const basic_animation<Scalar>& a = animations[i];
+            assert((int) a.control_points.size() == count && "Todas as animações do lote precisam do mesmo grau!");
+            assert(a.t_function == out->t_function && "Todas as animações do lote precisam do mesmo easing!");
+            for (int k = 0; k < count; k++) {
+                out->x[k * size + i] = a.control_points[k].x;
+                out->y[k * size + i] = a.control_points[k].y;
+            }
+            out->cx[i] = a.C.x;
+            out->cy[i] = a.C.y;
+            out->time_count[i] = a.time_count;
+            out->time_to_complete[i] = a.time_to_complete;
+            out->flags[i] = (a.reverse ? BZ_BATCH_REVERSE : 0) | (a.loop ? BZ_BATCH_LOOP : 0);
+        }
+    }
+
+    template<typename Scalar>
+    point<Scalar> batch_point(const animation_batch<Scalar>& batch, const std::size_t i) {
+        return {batch.cx[i], batch.cy[i]};
+    }
+
+    /**
+     * Uma coordenada (x ou y) da curva de todas as animações do lote em u[i].
+     * Uma coordenada por laço deixa poucos ponteiros para o compilador checar
+     * sobreposição, e os graus 1 a 3 viram laços vetorizados sem desvios. Os
+     * outros usam de Casteljau em work (count * size), um nível por vez, com o
+     * laço de dentro também sobre as animações.
+    */
+    template<typename Scalar>
+    void evaluate_batch_axis(
+        const Scalar* p,
+        const Scalar* u,
+        Scalar* out,
+        const std::size_t size,
+        const int count,
+        Scalar* work
+    ) {
+        const Scalar one = Scalar(1);
+        switch (count) {
+            case 2:
+                for (std::size_t i = 0; i < size; i++) {
+                    const Scalar t = u[i], s = one - t;
+                    out[i] = s * p[i] + t * p[size + i];
+                }
+                return;
+            case 3:
+                for (std::size_t i = 0; i < size; i++) {
+                    const Scalar t = u[i], s = one - t;
+                    out[i] = s * s * p[i] + Scalar(2) * s * t * p[size + i] + t * t * p[2 * size + i];
+                }
+                return;
+            case 4:
+                for (std::size_t i = 0; i < size; i++) {
+                    const Scalar t = u[i], s = one - t;
+                    out[i] = s * s * s * p[i] + Scalar(3) * s * s * t * p[size + i]
+                        + Scalar(3) * s * t * t * p[2 * size + i] + t * t * t * p[3 * size + i];
+                }
+                return;
+            default:
+                break;
+        }
+        std::copy(p + size, p + count * size, work + size);
+        for (std::size_t i = 0; i < size; i++) {
+            work[i] = p[i];
+        }
+        for (int r = count - 1; r > 0; r--) {
+            for (int j = 0; j < r; j++) {
+                Scalar* q = work + j * size;
+                const Scalar* next = q + size;
+                for (std::size_t i = 0; i < size; i++) {
+                    q[i] = (one - u[i]) * q[i] + u[i] * next[i];
+                }
+            }
+        }
+        std::copy(work, work + size, out);
+    }
+
+    /**
+     * Curva de todas as animações do lote em u[i] (já com o easing). work só
+     * é usado acima do grau 3.
+    */
+    template<typename Scalar>
+    void evaluate_batch(animation_batch<Scalar>* batch, const Scalar* u, std::vector<Scalar>* work) {
+        const std::size_t size = batch->size();
+        if (batch->count > 4) {
+            work->resize(batch->count * size);
+        }
+        bz::evaluate_batch_axis(batch->x.data(), u, batch->cx.data(), size, batch->count, work->data());
+        bz::evaluate_batch_axis(batch->y.data(), u, batch->cy.data(), size, batch->count, work->data());
+    }
+
+    /**
+     * Avança o relógio de todas as animações e escreve o t com easing em u.
+     * O mesmo que update_progress, sem desvios: a volta do loop vira seleção,
+     * e o easing é um só por lote, então as duas passadas são vetorizadas.
+    */
+    template<typename Scalar>
+    void advance_batch(animation_batch<Scalar>* batch, const Scalar dt, Scalar* u) {
+        const std::size_t size = batch->size();
+        const Scalar one = Scalar(1);
+        Scalar* time_count = batch->time_count.data();
+        const Scalar* time_to_complete = batch->time_to_complete.data();
+        std::uint8_t* flags = batch->flags.data();
+        for (std::size_t i = 0; i < size; i++) {
+            const Scalar count = time_count[i] + dt;
+            const std::uint8_t f = flags[i];
+            const Scalar t = count / time_to_complete[i];
+            const Scalar v = (f & BZ_BATCH_REVERSE) ? one - t : t;
+            const bool wrap = (f & BZ_BATCH_LOOP) && (v > one || v < Scalar(0));
+            flags[i] = wrap ? f ^ BZ_BATCH_REVERSE : f;
+            time_count[i] = wrap ? Scalar(0) : count;
+            u[i] = v;
+        }
+        const TBasicFunction function = batch->t_function;
+        if (function != TBasicFunction::Normal) {
+            for (std::size_t i = 0; i < size; i++) {
+                u[i] = bz::apply_t_function(function, u[i]);
+            }
+        }
+    }
+
+    /**
+     * Memória temporária de animation_update(animation_batch*), reaproveitada
+     * entre frames
+    */
+    template<typename Scalar>
+    struct batch_scratch {
+        std::vector<Scalar> t;    // t com easing, entre as duas passadas
+        std::vector<Scalar> work; // Níveis de de Casteljau (grau > 3)
+    };
+
+    /**
+     * Duas passadas: o tempo e o easing, depois a curva do lote inteiro
+    */
+    template<typename Scalar>
+    void animation_update(animation_batch<Scalar>* batch, const Scalar dt, batch_scratch<Scalar>* scratch) {
+        BZ_PROFILE_ZONE("scalar_batch_update");
+        scratch->t.resize(batch->size());
+        bz::advance_batch(batch, dt, scratch->t.data());
+        bz::evaluate_batch(batch, scratch->t.data(), &scratch->work);
+    }
+
+    template<typename Scalar>
+    Vector2 to_vector2(const point<Scalar> p) {
+        return {(float) p.x, (float) p.y};
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef BEZIER_SNAPSHOT_H
+#define BEZIER_SNAPSHOT_H
+#include "bezier_profile.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * Anel de snapshots do estado da simulação, para rollback e "voltar no tempo".
+ *
+ * Um snapshot é uma lista de blobs (arrays de tipos trivialmente copiáveis,
+ * na ordem em que foram salvos) guardados em páginas de BZ_SNAPSHOT_PAGE
+ * bytes. Cada página é comparada com a página de mesmo índice do snapshot
+ * anterior: se não mudou, ela é compartilhada (contagem de referências) em
+ * vez de copiada, então arrays que não mudaram entre dois snapshots não
+ * ocupam memória nova. Páginas liberadas voltam para uma lista livre, então
+ * em regime salvar não aloca.
+ *
+ * Salvar e restaurar são memcpy de páginas: quem salva só precisa ler e
+ * escrever os blobs na mesma ordem (snapshot_writer_t / snapshot_reader_t).
+*/
+namespace bz {
+
+
+    #define BZ_SNAPSHOT_PAGE 4096
+    #define BZ_SNAPSHOT_RING 8
+
+    typedef struct snapshot_page {
+        std::uint32_t refs = 0;
+        std::byte data[BZ_SNAPSHOT_PAGE];
+    } snapshot_page_t;
+
+    typedef struct snapshot_blob {
+        std::size_t size = 0;
+        std::vector<snapshot_page_t*> pages;
+    } snapshot_blob_t;
+
+    typedef struct snapshot {
+        std::uint64_t frame = 0;
+        std::vector<snapshot_blob_t> blobs;
+        std::size_t blob_count = 0; // blobs.size() só cresce, para reaproveitar os vetores de páginas
+        bool valid = false;
+    } snapshot_t;
+
+    typedef struct snapshot_ring {
+        std::vector<snapshot_t> slots;
+        std::vector<std::unique_ptr<snapshot_page_t>> storage; // Dona de todas as páginas
+        std::vector<snapshot_page_t*> free_pages;
+        std::uint32_t next = 0;       // Slot do próximo snapshot
+        snapshot_t* last = NULL;      // Snapshot mais novo (base da comparação)
+        std::size_t copied = 0;       // Páginas copiadas / compartilhadas no último snapshot
+        std::size_t shared = 0;
+    } snapshot_ring_t;
+
+    typedef struct snapshot_writer {
+        snapshot_ring_t* ring = NULL;
+        snapshot_t* out = NULL;
+        const snapshot_t* base = NULL;
+        std::size_t blob = 0;
+    } snapshot_writer_t;
+
+    typedef struct snapshot_reader {
+        const snapshot_t* snapshot = NULL;
+        std::size_t blob = 0;
+    } snapshot_reader_t;
+
+    /**
+     * Anel com slots snapshots (pelo menos 2: o novo é comparado com o anterior)
+    */
+    void init_snapshot_ring(snapshot_ring_t* ring, const std::uint32_t slots = BZ_SNAPSHOT_RING) {
+        assert(slots >= 2);
+        *ring = snapshot_ring_t{};
+        ring->slots.resize(slots);
+    }
+
+    snapshot_page_t* acquire_page(snapshot_ring_t* ring) {
+        if (ring->free_pages.empty()) {
+            ring->storage.push_back(std::make_unique<snapshot_page_t>());
+            return ring->storage.back().get();
+        }
+        snapshot_page_t* page = ring->free_pages.back();
+        ring->free_pages.pop_back();
+        return page;
+    }
+
+    void release_page(snapshot_ring_t* ring, snapshot_page_t* page) {
+        if (--page->refs == 0) {
+            ring->free_pages.push_back(page);
+        }
+    }
+
+    void release_snapshot(snapshot_ring_t* ring, snapshot_t* snapshot) {
+        for (std::size_t b = 0; b < snapshot->blob_count; b++) {
+            for (snapshot_page_t* page : snapshot->blobs[b].pages) {
+                bz::release_page(ring, page);
+            }
+            snapshot->blobs[b].pages.clear();
+            snapshot->blobs[b].size = 0;
+        }
+        snapshot->blob_count = 0;
+        snapshot->valid = false;
+        if (ring->last == snapshot) {
+            ring->last = NULL;
+        }
+    }
+
+    /**
+     * Começa um snapshot no slot mais antigo (descartando o que estava lá)
+    */
+    snapshot_writer_t begin_snapshot(snapshot_ring_t* ring, const std::uint64_t frame) {
+        snapshot_t* out = &ring->slots[ring->next];
+        bz::release_snapshot(ring, out);
+        out->frame = frame;
+        ring->copied = 0;
+        ring->shared = 0;
+        return {ring, out, ring->last, 0};
+    }
+
+    /**
+     * Próximo blob do snapshot. Páginas iguais às do mesmo blob no snapshot
+     * anterior são compartilhadas.
+    */
+    void save_bytes(snapshot_writer_t* writer, const void* data, const std::size_t size) {
+        snapshot_t* out = writer->out;
+        if (out->blobs.size() <= writer->blob) {
+            out->blobs.resize(writer->blob + 1);
+        }
+        snapshot_blob_t& blob = out->blobs[writer->blob];
+        const snapshot_blob_t* base = writer->base != NULL && writer->blob < writer->base->blob_count
+            ? &writer->base->blobs[writer->blob]
+            : NULL;
+        writer->blob++;
+        out->blob_count = writer->blob;
+        blob.size = size;
+        const std::byte* bytes = (const std::byte*) data;
+        for (std::size_t offset = 0, i = 0; offset < size; offset += BZ_SNAPSHOT_PAGE, i++) {
+            const std::size_t n = std::min<std::size_t>(BZ_SNAPSHOT_PAGE, size - offset);
+            if (base != NULL && i < base->pages.size() &&
+                std::min<std::size_t>(BZ_SNAPSHOT_PAGE, base->size - offset) == n &&
+                std::memcmp(base->pages[i]->data, bytes + offset, n) == 0) {
+                snapshot_page_t* page = base->pages[i];
+                page->refs++;
+                blob.pages.push_back(page);
+                writer->ring->shared++;
+                continue;
+            }
+            snapshot_page_t* page = bz::acquire_page(writer->ring);
+            page->refs = 1;
+            std::memcpy(page->data, bytes + offset, n);
+            blob.pages.push_back(page);
+            writer->ring->copied++;
+        }
+    }
+
+    template <typename T>
+    void save_value(snapshot_writer_t* writer, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "o snapshot só copia memória");
+        bz::save_bytes(writer, &value, sizeof(T));
+    }
+
+    template <typename T, typename Allocator>
+    void save_array(snapshot_writer_t* writer, const std::vector<T, Allocator>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "o snapshot só copia memória");
+        bz::save_bytes(writer, values.data(), values.size() * sizeof(T));
+    }
+
+    /**
+     * Fecha o snapshot: ele vira o mais novo do anel
+    */
+    void end_snapshot(snapshot_writer_t* writer) {
+        snapshot_ring_t* ring = writer->ring;
+        writer->out->valid = true;
+        ring->last = writer->out;
+        ring->next = (ring->next + 1) % ring->slots.size();
+    }
+
+    /**
+     * O snapshot mais novo com frame <= frame, ou NULL
+    */
+    const snapshot_t* find_snapshot(const snapshot_ring_t& ring, const std::uint64_t frame) {
+        const snapshot_t* found = NULL;
+        for (const snapshot_t& snapshot : ring.slots) {
+            if (snapshot.valid && snapshot.frame <= frame && (found == NULL || snapshot.frame > found->frame)) {
+                found = &snapshot;
+            }
+        }
+        return found;
+    }
+
+    /**
+     * Descarta os snapshots mais novos que snapshot (depois de um rollback
+     * eles descrevem um futuro que vai ser simulado de novo)
+    */
+    void rewind_ring(snapshot_ring_t* ring, const snapshot_t* snapshot) {
+        for (snapshot_t& s : ring->slots) {
+            if (s.valid && s.frame > snapshot->frame) {
+                bz::release_snapshot(ring, &s);
+            }
+        }
+        const std::size_t index = snapshot - ring->slots.data();
+        ring->last = &ring->slots[index];
+        ring->next = (index + 1) % ring->slots.size();
+    }
+
+    snapshot_reader_t read_snapshot(const snapshot_t* snapshot) {
+        return {snapshot, 0};
+    }
+
+    /**
+     * Tamanho em bytes do próximo blob
+    */
+    std::size_t next_blob_size(const snapshot_reader_t& reader) {
+        assert(reader.blob < reader.snapshot->blob_count);
+        return reader.snapshot->blobs[reader.blob].size;
+    }
+
+    void load_bytes(snapshot_reader_t* reader, void* data) {
+        const snapshot_blob_t& blob = reader->snapshot->blobs[reader->blob++];
+        std::byte* bytes = (std::byte*) data;
+        for (std::size_t offset = 0, i = 0; offset < blob.size; offset += BZ_SNAPSHOT_PAGE, i++) {
+            std::memcpy(bytes + offset, blob.pages[i]->data, std::min<std::size_t>(BZ_SNAPSHOT_PAGE, blob.size - offset));
+        }
+    }
+
+    template <typename T>
+    void load_value(snapshot_reader_t* reader, T* value) {
+        static_assert(std::is_trivially_copyable_v<T>, "o snapshot só copia memória");
+        assert(next_blob_size(*reader) == sizeof(T));
+        bz::load_bytes(reader, value);
+    }
+
+    template <typename T, typename Allocator>
+    void load_array(snapshot_reader_t* reader, std::vector<T, Allocator>* values) {
+        static_assert(std::is_trivially_copyable_v<T>, "o snapshot só copia memória");
+        values->resize(next_blob_size(*reader) / sizeof(T));
+        bz::load_bytes(reader, values->data());
+    }
+
+    /**
+     * Memória ocupada pelas páginas (em uso + livres)
+    */
+    std::size_t snapshot_memory(const snapshot_ring_t& ring) {
+        return ring.storage.size() * sizeof(snapshot_page_t);
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
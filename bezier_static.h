@@ -0,0 +1,123 @@
+#ifndef BEZIER_STATIC_H
+#define BEZIER_STATIC_H
+#include "bezier.h"
+#include <array>
+#include <cstddef>
+#include <utility>
+
+
+/**
+ * Curvas de grau fixo conhecido em tempo de compilação.
+ *
+ * bz::bezier<N, Scalar> guarda os N + 1 pontos em um std::array e usa uma
+ * linha do triângulo de Pascal calculada em constexpr; a soma de Bernstein é
+ * desenrolada por fold expression. Tudo é constexpr, então caminhos conhecidos
+ * no build podem virar tabelas estáticas (bake_static) sem inicialização em
+ * tempo de execução. bz::wrap faz uma bezier_animation_t avaliar pela curva fixa.
+*/
+namespace bz {
+
+
+    template<typename Scalar>
+    struct point {
+        Scalar x;
+        Scalar y;
+    };
+
+    /**
+     * Linha n do triângulo de Pascal: C(n, 0), ..., C(n, n)
+    */
+    template<int N, typename Scalar>
+    constexpr std::array<Scalar, N + 1> pascal_row() {
+        std::array<Scalar, N + 1> row{};
+        row[0] = Scalar(1);
+        for (int i = 1; i <= N; i++) {
+            for (int k = i; k > 0; k--) {
+                row[k] += row[k - 1];
+            }
+        }
+        return row;
+    }
+
+    template<int N, typename Scalar = float>
+    struct bezier {
+        static_assert(N >= 1, "bz::bezier precisa de grau >= 1");
+        static constexpr int degree = N;
+        static constexpr std::array<Scalar, N + 1> binomials = pascal_row<N, Scalar>();
+        std::array<point<Scalar>, N + 1> points;
+    };
+
+    /**
+     * Cria a curva a partir dos pontos (Vector2), com o grau deduzido: make_bezier(p0, p1, p2)
+    */
+    template<typename Scalar = float, typename... P>
+    constexpr bezier<sizeof...(P) - 1, Scalar> make_bezier(const P&... p) {
+        return {{{point<Scalar>{(Scalar) p.x, (Scalar) p.y}...}}};
+    }
+
+    template<int N, typename Scalar, std::size_t... K>
+    constexpr point<Scalar> evaluate_unrolled(
+        const bezier<N, Scalar>& curve,
+        const Scalar t,
+        std::index_sequence<K...>
+    ) {
+        const Scalar s = Scalar(1) - t;
+        std::array<Scalar, N + 1> tk{}; // t^k
+        std::array<Scalar, N + 1> sk{}; // (1 - t)^k
+        tk[0] = Scalar(1);
+        sk[0] = Scalar(1);
+        ((K > 0 ? (tk[K] = tk[K > 0 ? K - 1 : 0] * t, sk[K] = sk[K > 0 ? K - 1 : 0] * s) : Scalar(0)), ...);
+        constexpr std::array<Scalar, N + 1> b = bezier<N, Scalar>::binomials;
+        return {
+            ((b[K] * tk[K] * sk[N - K] * curve.points[K].x) + ...),
+            ((b[K] * tk[K] * sk[N - K] * curve.points[K].y) + ...)
+        };
+    }
+
+    template<int N, typename Scalar>
+    constexpr point<Scalar> evaluate(const bezier<N, Scalar>& curve, const Scalar t) {
+        return evaluate_unrolled(curve, t, std::make_index_sequence<N + 1>{});
+    }
+
+    /**
+     * S amostras igualmente espaçadas em t; com um curve constexpr o resultado
+     * pode ser um constexpr std::array
+    */
+    template<int S, int N, typename Scalar>
+    constexpr std::array<Vector2, S> bake_static(const bezier<N, Scalar>& curve) {
+        static_assert(S > 1, "bake_static precisa de pelo menos 2 amostras");
+        std::array<Vector2, S> table{};
+        for (int i = 0; i < S; i++) {
+            const point<Scalar> p = evaluate(curve, Scalar(i) / Scalar(S - 1));
+            table[i] = {(float) p.x, (float) p.y};
+        }
+        return table;
+    }
+
+    template<int N, typename Scalar>
+    Vector2 evaluate_fixed(const void* curve, const double t) {
+        const point<Scalar> p = evaluate(*static_cast<const bezier<N, Scalar>*>(curve), (Scalar) t);
+        return {(float) p.x, (float) p.y};
+    }
+
+    /**
+     * A animação passa a ser avaliada pela curva fixa (que não é copiada e deve
+     * viver mais que a animação). Os pontos de controle são copiados para quem
+     * os lê (desenho, seguir alvo...); mudá-los pelas funções do bz desfaz o wrap.
+    */
+    template<int N, typename Scalar>
+    void wrap(bezier_animation_t* animation, const bezier<N, Scalar>* curve) {
+        animation->control_points.clear();
+        for (const point<Scalar>& p : curve->points) {
+            animation->control_points.push_back({(float) p.x, (float) p.y});
+        }
+        bz::control_points_changed(animation);
+        animation->fixed = {curve, &evaluate_fixed<N, Scalar>};
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
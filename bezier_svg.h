@@ -0,0 +1,410 @@
+#ifndef BEZIER_SVG_H
+#define BEZIER_SVG_H
+#include "bezier.h"
+#include "bezier_bake.h"
+#include "bezier_template.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#define NANOSVG_IMPLEMENTATION
+#include "external/nanosvg.h"
+
+
+/**
+ * Importa caminhos de arquivos SVG (via o nanosvg que vem com o raylib).
+ *
+ * O nanosvg converte todo elemento (path, rect, circle, arcos...) em cadeias
+ * de Béziers cúbicas: P0, depois (C1, C2, P1) por segmento. Cada caminho vira
+ *   - um baked_path_t (bezier_bake.h) amostrado por comprimento de arco, para
+ *     o bullet andar com velocidade (quase) constante por todos os segmentos,
+ *     sem cortar as quinas; ou
+ *   - um modelo por segmento em template_library_t (bezier_template.h).
+ * O parse é serial, mas o achatamento/amostragem dos caminhos roda em
+ * paralelo, um caminho por vez por thread. svg_cache_t evita reimportar um
+ * arquivo que não mudou.
+*/
+namespace bz {
+
+
+    #define BZ_SVG_DPI 96.f
+    #define BZ_SVG_MAX_SPACING 16.0 // Espaçamento inicial das amostras, em pixels
+    #define BZ_SVG_CORNER_COS 0.866 // Vértice achatado que vira mais de 30 graus é quina
+
+    typedef struct svg_path {
+        std::string id;              // Atributo id do elemento (ou do grupo)
+        std::vector<Vector2> points; // P0, C1, C2, P1, C1, C2, P2, ...
+        bool closed = false;
+    } svg_path_t;
+
+    typedef struct svg_document {
+        std::vector<svg_path_t> paths;
+        Vector2 size = {0.f, 0.f};
+    } svg_document_t;
+
+    int segment_count(const svg_path_t& path) {
+        return ((int) path.points.size() - 1) / 3;
+    }
+
+    void read_svg_image(NSVGimage* image, svg_document_t* out) {
+        out->paths.clear();
+        out->size = {image->width, image->height};
+        for (NSVGshape* shape = image->shapes; shape != NULL; shape = shape->next) {
+            for (NSVGpath* path = shape->paths; path != NULL; path = path->next) {
+                if (path->npts < 4) {
+                    continue;
+                }
+                svg_path_t& p = out->paths.emplace_back();
+                p.id = shape->id;
+                p.closed = path->closed != 0;
+                p.points.resize(path->npts);
+                for (int i = 0; i < path->npts; i++) {
+                    p.points[i] = {path->pts[2 * i], path->pts[2 * i + 1]};
+                }
+            }
+        }
+        nsvgDelete(image);
+    }
+
+    bool load_svg(const char* filename, svg_document_t* out, const float dpi = BZ_SVG_DPI) {
+        NSVGimage* image = nsvgParseFromFile(filename, "px", dpi);
+        if (image == NULL) {
+            return false;
+        }
+        bz::read_svg_image(image, out);
+        return true;
+    }
+
+    /**
+     * Parse de um SVG em memória (o nanosvg altera o texto, então ele é copiado)
+    */
+    bool parse_svg(std::string text, svg_document_t* out, const float dpi = BZ_SVG_DPI) {
+        NSVGimage* image = nsvgParse(text.data(), "px", dpi);
+        if (image == NULL) {
+            return false;
+        }
+        bz::read_svg_image(image, out);
+        return true;
+    }
+
+    /**
+     * Quantidade de retas para achatar o segmento cúbico com erro <= tolerance
+     * (fórmula de Wang: depende só das segundas diferenças dos pontos)
+    */
+    int flatten_steps(const Vector2* p, const double tolerance) {
+        const float dx0 = p[0].x - 2.f * p[1].x + p[2].x, dy0 = p[0].y - 2.f * p[1].y + p[2].y;
+        const float dx1 = p[1].x - 2.f * p[2].x + p[3].x, dy1 = p[1].y - 2.f * p[2].y + p[3].y;
+        const double m = std::sqrt(std::max(dx0 * dx0 + dy0 * dy0, dx1 * dx1 + dy1 * dy1));
+        return std::max(1, (int) std::ceil(std::sqrt(0.75 * m / tolerance)));
+    }
+
+    /**
+     * Achata a cadeia de cúbicas numa polilinha. Cada segmento é avaliado em
+     * lote por diferenças progressivas (3 somas por ponto). Se joins não for
+     * NULL recebe o índice do vértice final de cada segmento.
+    */
+    void flatten_svg_path(
+        const svg_path_t& path,
+        const double tolerance,
+        std::vector<Vector2>* out,
+        std::vector<std::size_t>* joins = NULL
+    ) {
+        out->clear();
+        if (joins != NULL) {
+            joins->clear();
+        }
+        out->push_back(path.points[0]);
+        for (int s = 0; s < segment_count(path); s++) {
+            const Vector2* p = path.points.data() + 3 * s;
+            const int n = bz::flatten_steps(p, tolerance);
+            const double h = 1.0 / n;
+            // B(t) = a*t^3 + b*t^2 + c*t + p0
+            const double ax = -p[0].x + 3.0 * p[1].x - 3.0 * p[2].x + p[3].x;
+            const double ay = -p[0].y + 3.0 * p[1].y - 3.0 * p[2].y + p[3].y;
+            const double bx = 3.0 * p[0].x - 6.0 * p[1].x + 3.0 * p[2].x;
+            const double by = 3.0 * p[0].y - 6.0 * p[1].y + 3.0 * p[2].y;
+            const double cx = 3.0 * (p[1].x - p[0].x), cy = 3.0 * (p[1].y - p[0].y);
+            double x = p[0].x, y = p[0].y;
+            double d1x = ax * h * h * h + bx * h * h + cx * h, d1y = ay * h * h * h + by * h * h + cy * h;
+            double d2x = 6.0 * ax * h * h * h + 2.0 * bx * h * h, d2y = 6.0 * ay * h * h * h + 2.0 * by * h * h;
+            const double d3x = 6.0 * ax * h * h * h, d3y = 6.0 * ay * h * h * h;
+            for (int i = 1; i < n; i++) {
+                x += d1x; y += d1y;
+                d1x += d2x; d1y += d2y;
+                d2x += d3x; d2y += d3y;
+                out->push_back({(float) x, (float) y});
+            }
+            out->push_back(p[3]); // O fim do segmento exato, sem o erro acumulado
+            if (joins != NULL) {
+                joins->push_back(out->size() - 1);
+            }
+        }
+    }
+
+    /**
+     * Índices dos vértices que precisam virar amostras: as pontas, as juntas
+     * entre segmentos e as quinas (vértices em que a direção vira mais que
+     * BZ_SVG_CORNER_COS). Entre dois deles a polilinha é suave.
+    */
+    void polyline_breaks(
+        const std::vector<Vector2>& line,
+        const std::vector<std::size_t>& joins,
+        std::vector<std::size_t>* out
+    ) {
+        out->assign(1, 0);
+        std::size_t join = 0;
+        for (std::size_t i = 1; i + 1 < line.size(); i++) {
+            while (join < joins.size() && joins[join] < i) {
+                join++;
+            }
+            const Vector2 d0 = Vector2Subtract(line[i], line[i - 1]);
+            const Vector2 d1 = Vector2Subtract(line[i + 1], line[i]);
+            const float norms = Vector2Length(d0) * Vector2Length(d1);
+            const bool corner = norms > 0.f && Vector2DotProduct(d0, d1) < BZ_SVG_CORNER_COS * norms;
+            if (corner || (join < joins.size() && joins[join] == i)) {
+                out->push_back(i);
+            }
+        }
+        if (line.size() > 1) {
+            out->push_back(line.size() - 1);
+        }
+    }
+
+    /**
+     * Ponto da polilinha no comprimento de arco s; length[i] é o comprimento
+     * acumulado até o vértice i e *hint a última aresta usada (busca monótona)
+    */
+    Vector2 polyline_point(const std::vector<Vector2>& line, const std::vector<double>& length, const double s, std::size_t* hint) {
+        std::size_t i = *hint;
+        while (i + 2 < line.size() && length[i + 1] < s) {
+            i++;
+        }
+        *hint = i;
+        const double edge = length[i + 1] - length[i];
+        const float f = edge > 0.0 ? (float) std::clamp((s - length[i]) / edge, 0.0, 1.0) : 0.f;
+        return Vector2Lerp(line[i], line[i + 1], f);
+    }
+
+    /**
+     * Amostra o caminho por comprimento de arco, reduzindo o espaçamento pela
+     * metade até a interpolação linear das amostras passar a menos de
+     * tolerance de todos os vértices achatados. Juntas e quinas viram amostras
+     * (uma amostragem uniforme cortaria a quina por até meio espaçamento):
+     * cada trecho entre elas é dividido em partes iguais de no máximo o
+     * espaçamento, então a velocidade só varia de um trecho para outro.
+    */
+    bool bake_svg_path(const svg_path_t& path, const double tolerance, baked_path_t* out) {
+        std::vector<Vector2> line;
+        std::vector<std::size_t> joins;
+        bz::flatten_svg_path(path, tolerance * 0.5, &line, &joins);
+        std::vector<std::size_t> breaks;
+        bz::polyline_breaks(line, joins, &breaks);
+        std::vector<double> length(line.size(), 0.0);
+        for (std::size_t i = 1; i < line.size(); i++) {
+            length[i] = length[i - 1] + Vector2Distance(line[i - 1], line[i]);
+        }
+        const double total = length.back();
+        out->interpolation = TInterpolation::LinearInterpolation;
+        if (total <= 0.0) {
+            out->samples.assign(2, line[0]);
+            out->error = 0.f;
+            return true;
+        }
+        const std::size_t pieces = breaks.size() - 1;
+        std::vector<int> parts(pieces);
+        double spacing = std::min(BZ_SVG_MAX_SPACING, total / (BZ_BAKE_MIN_SAMPLES - 1));
+        for (;; spacing *= 0.5) {
+            // Partes por trecho; com o limite de amostras estourado o espaçamento não desce mais
+            int n = 1;
+            for (std::size_t p = 0; p < pieces; p++) {
+                const double piece = length[breaks[p + 1]] - length[breaks[p]];
+                parts[p] = std::max(1, (int) std::ceil(piece / spacing - 1e-9));
+                n += parts[p];
+            }
+            if (n > BZ_BAKE_MAX_SAMPLES) {
+                return false;
+            }
+            out->samples.resize(n);
+            std::size_t hint = 0;
+            int first = 0;
+            for (std::size_t p = 0; p < pieces; p++) {
+                const double start = length[breaks[p]];
+                const double piece = length[breaks[p + 1]] - start;
+                for (int k = 0; k < parts[p]; k++) {
+                    out->samples[first + k] = bz::polyline_point(line, length, start + piece * k / parts[p], &hint);
+                }
+                first += parts[p];
+            }
+            out->samples.back() = line.back();
+            // Cada vértice achatado é comparado com a amostra no mesmo ponto do seu trecho
+            double error = 0.0;
+            first = 0;
+            for (std::size_t p = 0; p < pieces; p++) {
+                const double start = length[breaks[p]];
+                const double piece = length[breaks[p + 1]] - start;
+                for (std::size_t i = breaks[p]; i <= breaks[p + 1]; i++) {
+                    const double f = piece > 0.0 ? (length[i] - start) / piece : 0.0;
+                    const double u = (first + f * parts[p]) / (n - 1);
+                    error = std::max(error, (double) Vector2Distance(line[i], sample_baked_path(*out, u)));
+                }
+                first += parts[p];
+            }
+            out->error = (float) (error + tolerance * 0.5);
+            if (out->error <= tolerance) {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Amostra todos os caminhos do documento em paralelo e os acrescenta à
+     * biblioteca na ordem do documento (a partir de into, reaproveitando
+     * caminhos já liberados, se into >= 0). Retorna o id do primeiro (os
+     * demais são consecutivos), ou -1 sem mexer na biblioteca se algum
+     * caminho não atingir a tolerância com BZ_BAKE_MAX_SAMPLES amostras.
+    */
+    int bake_svg_document(
+        bake_library_t* library,
+        const svg_document_t& document,
+        const double tolerance = BZ_BAKE_TOLERANCE,
+        unsigned threads = 0,
+        const int into = -1
+    ) {
+        BZ_PROFILE_ZONE("bake_svg_document");
+        const std::size_t count = document.paths.size();
+        std::vector<baked_path_t> baked(count);
+        std::vector<char> ok(count, 0);
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = (unsigned) std::min<std::size_t>(threads, count);
+        std::atomic<std::size_t> next{0};
+        const auto work = [&]() {
+            for (std::size_t i = next++; i < count; i = next++) {
+                ok[i] = bz::bake_svg_path(document.paths[i], tolerance, &baked[i]);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            if (!ok[i]) {
+                std::fprintf(
+                    stderr, "bz::svg: caminho %zu (\"%s\") com erro %.3g, acima da tolerância %.3g\n",
+                    i, document.paths[i].id.c_str(), baked[i].error, tolerance
+                );
+                return -1;
+            }
+        }
+        const int first = into >= 0 ? into : (int) library->paths.size();
+        assert(first <= (int) library->paths.size());
+        for (std::size_t i = 0; i < count; i++) {
+            if (first + i < library->paths.size()) {
+                library->paths[first + i] = std::move(baked[i]);
+            } else {
+                library->paths.push_back(std::move(baked[i]));
+            }
+        }
+        return first;
+    }
+
+    /**
+     * Um modelo de 4 pontos por segmento. Retorna o id do primeiro.
+    */
+    int add_svg_templates(template_library_t* library, const svg_path_t& path) {
+        const int first = (int) library->templates.size();
+        for (int s = 0; s < segment_count(path); s++) {
+            const Vector2* p = path.points.data() + 3 * s;
+            bz::add_template(library, std::vector<Vector2>(p, p + 4));
+        }
+        return first;
+    }
+
+    /**
+     * Índice do caminho com esse id no documento, ou -1
+    */
+    int find_svg_path(const svg_document_t& document, const std::string& id) {
+        for (std::size_t i = 0; i < document.paths.size(); i++) {
+            if (document.paths[i].id == id) {
+                return (int) i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Arquivos já importados: o mesmo arquivo com a mesma tolerância só é lido
+     * de novo se a data de modificação mudar
+    */
+    typedef struct svg_cache_entry {
+        std::filesystem::file_time_type modified;
+        svg_document_t document;
+        int first_path = -1; // Id do primeiro caminho em bake_library_t
+        int path_count = 0;
+    } svg_cache_entry_t;
+
+    typedef struct svg_cache {
+        std::map<std::pair<std::string, double>, svg_cache_entry_t> entries;
+    } svg_cache_t;
+
+    /**
+     * Importa (ou reaproveita) o arquivo. Retorna a entrada, ou NULL se o
+     * arquivo não existir, não for um SVG ou algum caminho não atingir a
+     * tolerância. Se o arquivo mudou, os caminhos da importação anterior são
+     * liberados e os novos ocupam o lugar deles quando cabem (os ids antigos
+     * ficam inválidos).
+    */
+    const svg_cache_entry_t* import_svg(
+        svg_cache_t* cache,
+        bake_library_t* library,
+        const char* filename,
+        const double tolerance = BZ_BAKE_TOLERANCE
+    ) {
+        std::error_code error;
+        const std::filesystem::file_time_type modified = std::filesystem::last_write_time(filename, error);
+        if (error) {
+            return NULL;
+        }
+        svg_cache_entry_t& entry = cache->entries[{filename, tolerance}];
+        if (entry.first_path >= 0 && entry.modified == modified) {
+            return &entry;
+        }
+        const int old_first = entry.first_path;
+        const int old_count = entry.path_count;
+        if (old_first >= 0) {
+            bz::release_baked_paths(library, old_first, old_count);
+            entry.first_path = -1;
+        }
+        if (!bz::load_svg(filename, &entry.document)) {
+            cache->entries.erase({filename, tolerance});
+            return NULL;
+        }
+        // No fim da biblioteca o intervalo antigo foi removido e qualquer número de caminhos cabe
+        const int count = (int) entry.document.paths.size();
+        const bool reuse = old_first >= 0 && (count <= old_count || old_first == (int) library->paths.size());
+        entry.modified = modified;
+        entry.first_path = bz::bake_svg_document(library, entry.document, tolerance, 0, reuse ? old_first : -1);
+        entry.path_count = count;
+        if (entry.first_path < 0) {
+            cache->entries.erase({filename, tolerance});
+            return NULL;
+        }
+        return &entry;
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef BEZIER_TEMPLATE_H
+#define BEZIER_TEMPLATE_H
+#include "bezier.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+/**
+ * Curvas modelo imutáveis compartilhadas por várias animações.
+ *
+ * Curvas de Bézier são invariantes por transformações afins: transformar os
+ * pontos de controle e depois avaliar dá o mesmo que avaliar e depois
+ * transformar. Cada animação guarda só o id do modelo e uma transformação 2x3;
+ * o modelo é avaliado uma vez por (modelo, t) distinto no frame e o resultado é
+ * reaproveitado por todas as animações com o mesmo t (ex.: bullets da mesma onda).
+*/
+namespace bz {
+
+
+    /**
+     * Transformação afim 2x3:
+     *   x' = a*x + c*y + tx
+     *   y' = b*x + d*y + ty
+    */
+    typedef struct transform2d {
+        float a = 1.f, b = 0.f;
+        float c = 0.f, d = 1.f;
+        float tx = 0.f, ty = 0.f;
+    } transform2d_t;
+
+    Vector2 transform_point(const transform2d_t& m, const Vector2 p) {
+        return {m.a * p.x + m.c * p.y + m.tx, m.b * p.x + m.d * p.y + m.ty};
+    }
+
+    Vector2 transform_vector(const transform2d_t& m, const Vector2 v) {
+        return {m.a * v.x + m.c * v.y, m.b * v.x + m.d * v.y};
+    }
+
+    transform2d_t make_transform(const Vector2 scale, const Vector2 translation) {
+        transform2d_t m{};
+        m.a = scale.x;
+        m.d = scale.y;
+        m.tx = translation.x;
+        m.ty = translation.y;
+        return m;
+    }
+
+    typedef struct curve_template {
+        std::vector<Vector2> control_points; // Em coordenadas locais, nunca mudam
+        std::vector<Vector2> partial_points; // Os mesmos com o último zerado: evaluate_curve dá a soma parcial
+        // Cache da última avaliação: soma de b_k * P_k sem o último ponto e o peso do último
+        double cached_t = -1.0;
+        Vector2 cached_partial = {0.f, 0.f};
+        double cached_last_weight = 0.0;
+    } curve_template_t;
+
+    /**
+     * Entrada da tabela de avaliações do frame (endereçamento aberto por (id, t))
+    */
+    typedef struct template_sample {
+        int id = -1; // -1 = entrada vazia
+        double t = 0.0;
+        Vector2 partial = {0.f, 0.f};
+        float last_weight = 0.f;
+    } template_sample_t;
+
+    typedef struct template_library {
+        std::vector<curve_template_t> templates;
+        std::vector<template_sample_t> frame_samples;
+    } template_library_t;
+
+    int add_template(template_library_t* library, const std::vector<Vector2>& control_points) {
+        assert(control_points.size() > 1 && "Modelo precisa de pelo menos 2 pontos de controle!");
+        curve_template_t curve{};
+        curve.control_points = control_points;
+        curve.partial_points = control_points;
+        curve.partial_points.back() = Vector2Zero();
+        library->templates.push_back(curve);
+        return (int) library->templates.size() - 1;
+    }
+
+    /**
+     * Soma parcial S e peso w = t^n do último ponto, com os kernels de evaluate_curve
+    */
+    void sample_template(const curve_template_t& curve, const double t, Vector2* partial, double* last_weight) {
+        const int count = curve.partial_points.size();
+        *partial = bz::evaluate_curve(curve.partial_points.data(), count, t);
+        double w = t;
+        for (int k = 2; k < count; k++) {
+            w *= t;
+        }
+        *last_weight = w;
+    }
+
+    /**
+     * Avalia o modelo em t (já com a t_function aplicada), reaproveitando o
+     * resultado se o último t avaliado for o mesmo
+    */
+    const curve_template_t& evaluate_template(template_library_t* library, const int id, const double t) {
+        curve_template_t& curve = library->templates[id];
+        if (curve.cached_t == t) {
+            return curve;
+        }
+        sample_template(curve, t, &curve.cached_partial, &curve.cached_last_weight);
+        curve.cached_t = t;
+        return curve;
+    }
+
+    /**
+     * Animação sobre um modelo compartilhado. Com follows_target o último ponto de
+     * controle é trocado por end (em coordenadas do mundo) a cada frame.
+    */
+    typedef struct template_animation : animation_state {
+        int template_id = -1;
+        transform2d_t transform;
+        bool follows_target = false;
+        Vector2 end = {0.f, 0.f};
+    } template_animation_t;
+
+    /**
+     * Atualiza a posição do ponto C. Com o último peso w e a soma parcial S do modelo:
+     *   C = M*(S + w*P_n) + T                  (modelo completo)
+     *   C = M*S + (1 - w)*T + w*end            (último ponto substituído por end)
+    */
+    void place_template_point(
+        const curve_template_t& curve,
+        template_animation_t* animation,
+        const Vector2 partial,
+        const float w
+    ) {
+        const transform2d_t& m = animation->transform;
+        if (animation->follows_target) {
+            const Vector2 s = transform_vector(m, partial);
+            animation->C = {
+                s.x + (1.f - w) * m.tx + w * animation->end.x,
+                s.y + (1.f - w) * m.ty + w * animation->end.y
+            };
+        } else {
+            animation->C = transform_point(
+                m, Vector2Add(partial, Vector2Scale(curve.control_points.back(), w))
+            );
+        }
+    }
+
+    void animation_update(
+        template_library_t* library,
+        template_animation_t* animation,
+        const float dt
+    ) {
+        BZ_PROFILE_ZONE("template_animation_update");
+        const double t = bz::update_progress(animation, dt);
+        const curve_template_t& curve = bz::evaluate_template(library, animation->template_id, t);
+        place_template_point(curve, animation, curve.cached_partial, (float) curve.cached_last_weight);
+    }
+
+    #define BZ_TEMPLATE_FRAME_SAMPLES 4096 // Entradas da tabela do frame (potência de 2, ~96 KB, cabe no L2)
+
+    /**
+     * Atualiza um grupo de animações agrupando as avaliações por (modelo, t):
+     * cada par distinto é avaliado uma vez no frame, mesmo que as animações com
+     * o mesmo t não estejam lado a lado. A tabela fica pequena para caber no
+     * cache; depois de meio cheia os pares novos são avaliados sem guardar.
+    */
+    void animation_update(
+        template_library_t* library,
+        template_animation_t* animations,
+        const std::size_t count,
+        const float dt
+    ) {
+        BZ_PROFILE_ZONE("template_animation_update_batch");
+        constexpr std::size_t size = BZ_TEMPLATE_FRAME_SAMPLES;
+        static_assert((size & (size - 1)) == 0, "BZ_TEMPLATE_FRAME_SAMPLES precisa ser potência de 2!");
+        std::vector<template_sample_t>& table = library->frame_samples;
+        table.assign(size, template_sample_t{});
+        std::size_t used = 0;
+        template_sample_t overflow{};
+        const template_sample_t* last = NULL;
+        for (std::size_t i = 0; i < count; i++) {
+            template_animation_t* animation = animations + i;
+            const double t = bz::update_progress(animation, dt);
+            const curve_template_t& curve = library->templates[animation->template_id];
+            // Bullets da mesma onda costumam estar lado a lado: evita o hash
+            if (last != NULL && last->id == animation->template_id && last->t == t) {
+                place_template_point(curve, animation, last->partial, last->last_weight);
+                continue;
+            }
+            std::uint64_t bits;
+            std::memcpy(&bits, &t, sizeof(bits));
+            const std::uint64_t h = (bits ^ ((std::uint64_t) animation->template_id << 32)) * 0x9E3779B97F4A7C15ull;
+            std::size_t slot = (std::size_t) (h >> 32) & (size - 1);
+            while (table[slot].id != -1 && (table[slot].id != animation->template_id || table[slot].t != t)) {
+                slot = (slot + 1) & (size - 1);
+            }
+            template_sample_t* sample = &table[slot];
+            if (sample->id == -1) {
+                if (2 * used >= size) {
+                    sample = &overflow;
+                } else {
+                    used++;
+                }
+                double w;
+                sample_template(curve, t, &sample->partial, &w);
+                sample->id = animation->template_id;
+                sample->t = t;
+                sample->last_weight = (float) w;
+            }
+            place_template_point(curve, animation, sample->partial, sample->last_weight);
+            last = sample;
+        }
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -0,0 +1,469 @@
+#ifndef BEZIER_TRACE_H
+#define BEZIER_TRACE_H
+#include "bezier.h"
+#include "bezier_mmap.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Trace binário do estado dos bullets (id, posição, t) a cada tick, para
+ * análise offline (densidade, bullets que nunca saem da tela, regressões).
+ *
+ * Formato:
+ *   trace_header_t
+ *   por tick: trace_tick_header_t e as colunas id, x, y, t
+ * Cada coluna é codificada em delta (contra o bullet anterior do mesmo tick)
+ * + zigzag + varint (LEB128). Bullets do mesmo container nascem juntos, então
+ * os ids são quase consecutivos e t quase igual: a maioria das entradas cabe
+ * em 1 ou 2 bytes. x e y vão em ponto fixo (1 / BZ_TRACE_SCALE pixel) e t em
+ * 16 bits.
+ *
+ * A thread do jogo só copia os valores crus para o bloco da frente (SoA).
+ * Quando o próximo tick não cabe mais nele, os blocos trocam de lugar e uma
+ * thread escritora codifica e grava o bloco de trás enquanto o jogo preenche
+ * o outro. O jogo só espera se a escritora ainda estiver com o bloco anterior.
+ * A capacidade dos blocos acompanha BZ_TRACE_BLOCK_TICKS ticks do número de
+ * bullets vivos e cresce no fim do tick, então as colunas não realocam no
+ * meio de um tick e cada troca deixa a escritora com vários ticks de folga.
+ *
+ * A leitura (trace_view_t) mapeia o arquivo na memória e decodifica um tick
+ * por vez, sem carregar o trace inteiro.
+*/
+namespace bz {
+
+
+    #define BZ_TRACE_MAGIC 0x52545a42u       // "BZTR"
+    #define BZ_TRACE_VERSION 1u
+    #define BZ_TRACE_SCALE 64                // Subdivisões de pixel de x e y
+    #define BZ_TRACE_BLOCK_BULLETS (1 << 16) // Capacidade inicial de cada bloco, em bullets
+    #define BZ_TRACE_BLOCK_TICKS 4           // Ticks do número de bullets vivos que cabem num bloco
+
+    typedef struct trace_header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t scale;
+        std::uint32_t reserved;
+    } trace_header_t;
+
+    typedef struct trace_tick_header {
+        std::uint32_t tick;
+        std::uint32_t count; // Bullets no tick
+        std::uint32_t size;  // Bytes das colunas codificadas
+    } trace_tick_header_t;
+
+    static_assert(sizeof(trace_header_t) == 16, "layout do cabeçalho do trace mudou");
+    static_assert(sizeof(trace_tick_header_t) == 12, "layout do cabeçalho do tick mudou");
+
+    /**
+     * Valores crus de vários ticks, coluna por coluna
+    */
+    typedef struct trace_block {
+        std::vector<std::uint32_t> ticks;
+        std::vector<std::uint32_t> counts;
+        std::vector<std::uint32_t> ids;
+        std::vector<std::int32_t> x;
+        std::vector<std::int32_t> y;
+        std::vector<std::uint16_t> t;
+    } trace_block_t;
+
+    typedef struct trace_writer {
+        std::FILE* file = NULL;
+        trace_block_t blocks[2];
+        int front = 0;              // Bloco da thread do jogo; o outro é da escritora
+        bool pending = false;       // O bloco de trás está esperando/sendo gravado
+        bool closing = false;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::thread thread;
+        std::vector<std::uint8_t> encoded; // Só a escritora usa
+        std::uint32_t tick = 0;
+        std::uint32_t next_id = 1;
+        std::size_t capacity = BZ_TRACE_BLOCK_BULLETS; // Bullets reservados em cada bloco
+        std::uint64_t bullets = 0;
+        std::uint64_t bytes = 0;    // Gravados até agora (só a escritora escreve)
+        int stalls = 0;             // Trocas em que o jogo esperou a escritora
+        bool ok = true;
+    } trace_writer_t;
+
+    #define BZ_VARINT_MAX 5 // Bytes de um uint32 em varint
+
+    std::uint8_t* put_varint(std::uint8_t* out, std::uint32_t v) {
+        while (v >= 0x80) {
+            *out++ = (std::uint8_t) (v | 0x80);
+            v >>= 7;
+        }
+        *out++ = (std::uint8_t) v;
+        return out;
+    }
+
+    std::uint32_t zigzag(const std::int32_t v) {
+        return ((std::uint32_t) v << 1) ^ (std::uint32_t) (v >> 31);
+    }
+
+    std::int32_t unzigzag(const std::uint32_t v) {
+        return (std::int32_t) (v >> 1) ^ -(std::int32_t) (v & 1);
+    }
+
+    /**
+     * Uma coluna de count valores em delta + zigzag + varint
+    */
+    template <typename T>
+    std::uint8_t* put_column(std::uint8_t* out, const T* values, const std::uint32_t count) {
+        std::int32_t previous = 0;
+        for (std::uint32_t i = 0; i < count; i++) {
+            const std::int32_t v = (std::int32_t) values[i];
+            out = bz::put_varint(out, bz::zigzag((std::int32_t) ((std::uint32_t) v - (std::uint32_t) previous)));
+            previous = v;
+        }
+        return out;
+    }
+
+    /**
+     * Codifica o bloco inteiro em writer->encoded e grava
+    */
+    bool write_trace_block(trace_writer_t* writer, const trace_block_t& block) {
+        BZ_PROFILE_ZONE("write_trace_block");
+        std::vector<std::uint8_t>& encoded = writer->encoded;
+        // Pior caso de uma vez; o varint escreve direto no buffer
+        encoded.resize(block.ticks.size() * sizeof(trace_tick_header_t) + block.ids.size() * 4 * BZ_VARINT_MAX);
+        std::uint8_t* out = encoded.data();
+        std::size_t first = 0;
+        for (std::size_t k = 0; k < block.ticks.size(); k++) {
+            const std::uint32_t count = block.counts[k];
+            std::uint8_t* header = out;
+            out += sizeof(trace_tick_header_t);
+            out = bz::put_column(out, block.ids.data() + first, count);
+            out = bz::put_column(out, block.x.data() + first, count);
+            out = bz::put_column(out, block.y.data() + first, count);
+            out = bz::put_column(out, block.t.data() + first, count);
+            const trace_tick_header_t tick = {
+                block.ticks[k], count, (std::uint32_t) (out - header - sizeof(trace_tick_header_t))
+            };
+            std::memcpy(header, &tick, sizeof(tick));
+            first += count;
+        }
+        const std::size_t size = out - encoded.data();
+        writer->bytes += size;
+        return std::fwrite(encoded.data(), 1, size, writer->file) == size;
+    }
+
+    void run_trace_writer(trace_writer_t* writer) {
+        for (;;) {
+            int index;
+            {
+                std::unique_lock<std::mutex> lock(writer->mutex);
+                writer->wake.wait(lock, [&]() { return writer->pending || writer->closing; });
+                if (!writer->pending) {
+                    return;
+                }
+                index = 1 - writer->front;
+            }
+            trace_block_t& block = writer->blocks[index];
+            const bool ok = bz::write_trace_block(writer, block);
+            block.ticks.clear();
+            block.counts.clear();
+            block.ids.clear();
+            block.x.clear();
+            block.y.clear();
+            block.t.clear();
+            {
+                std::lock_guard<std::mutex> lock(writer->mutex);
+                writer->ok = writer->ok && ok;
+                writer->pending = false;
+            }
+            writer->wake.notify_all();
+        }
+    }
+
+    /**
+     * Reserva capacity bullets em cada coluna do bloco
+    */
+    void reserve_trace_block(trace_block_t* block, const std::size_t capacity) {
+        block->ids.reserve(capacity);
+        block->x.reserve(capacity);
+        block->y.reserve(capacity);
+        block->t.reserve(capacity);
+    }
+
+    /**
+     * Abre o arquivo, reserva os dois blocos e inicia a escritora
+    */
+    bool open_trace(trace_writer_t* writer, const char* path, const std::size_t capacity = BZ_TRACE_BLOCK_BULLETS) {
+        writer->file = std::fopen(path, "wb");
+        if (writer->file == NULL) {
+            return false;
+        }
+        const trace_header_t header = {BZ_TRACE_MAGIC, BZ_TRACE_VERSION, BZ_TRACE_SCALE, 0};
+        if (std::fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+            std::fclose(writer->file);
+            writer->file = NULL;
+            return false;
+        }
+        writer->capacity = capacity;
+        for (trace_block_t& block : writer->blocks) {
+            bz::reserve_trace_block(&block, capacity);
+        }
+        writer->encoded.reserve(capacity * 4 * BZ_VARINT_MAX);
+        writer->front = 0;
+        writer->pending = false;
+        writer->closing = false;
+        writer->tick = 0;
+        writer->next_id = 1;
+        writer->bullets = 0;
+        writer->bytes = sizeof(header);
+        writer->stalls = 0;
+        writer->ok = true;
+        writer->thread = std::thread(run_trace_writer, writer);
+        return true;
+    }
+
+    bool is_tracing(const trace_writer_t& writer) {
+        return writer.file != NULL;
+    }
+
+    void begin_tick(trace_writer_t* writer) {
+        trace_block_t& block = writer->blocks[writer->front];
+        block.ticks.push_back(writer->tick);
+        block.counts.push_back(0);
+    }
+
+    /**
+     * Posição em ponto fixo, arredondada sem chamar a libm
+    */
+    std::int32_t to_trace_fixed(const float v) {
+        const float scaled = v * BZ_TRACE_SCALE + 0.5f;
+        const std::int32_t i = (std::int32_t) scaled;
+        return i - ((float) i > scaled);
+    }
+
+    std::uint16_t to_trace_t(const double t) {
+        return (std::uint16_t) (std::clamp(t, 0.0, 1.0) * 65535.0 + 0.5);
+    }
+
+    void trace_bullet(trace_writer_t* writer, const std::uint32_t id, const Vector2 position, const double t) {
+        trace_block_t& block = writer->blocks[writer->front];
+        block.ids.push_back(id);
+        block.x.push_back(bz::to_trace_fixed(position.x));
+        block.y.push_back(bz::to_trace_fixed(position.y));
+        block.t.push_back(bz::to_trace_t(t));
+        block.counts.back()++;
+    }
+
+    /**
+     * Grava count animações; as que ainda não têm id ganham o próximo
+    */
+    template <typename Animation>
+    void trace_bullets(trace_writer_t* writer, Animation* animations, const std::size_t count) {
+        trace_block_t& block = writer->blocks[writer->front];
+        const std::size_t at = block.ids.size();
+        block.ids.resize(at + count);
+        block.x.resize(at + count);
+        block.y.resize(at + count);
+        block.t.resize(at + count);
+        for (std::size_t i = 0; i < count; i++) {
+            Animation& a = animations[i];
+            if (a.id == 0) {
+                a.id = writer->next_id++;
+            }
+            block.ids[at + i] = a.id;
+            block.x[at + i] = bz::to_trace_fixed(a.C.x);
+            block.y[at + i] = bz::to_trace_fixed(a.C.y);
+            block.t[at + i] = bz::to_trace_t(a.t);
+        }
+        block.counts.back() += count;
+    }
+
+    /**
+     * Passa o bloco da frente para a escritora (esperando se ela ainda estiver
+     * ocupada). O novo bloco da frente cresce até a capacidade atual.
+    */
+    void swap_trace_blocks(trace_writer_t* writer) {
+        BZ_PROFILE_ZONE("swap_trace_blocks");
+        {
+            std::unique_lock<std::mutex> lock(writer->mutex);
+            if (writer->pending) {
+                writer->stalls++;
+                writer->wake.wait(lock, [&]() { return !writer->pending; });
+            }
+            writer->front = 1 - writer->front;
+            writer->pending = true;
+        }
+        writer->wake.notify_all();
+        bz::reserve_trace_block(&writer->blocks[writer->front], writer->capacity);
+    }
+
+    void end_tick(trace_writer_t* writer) {
+        trace_block_t& block = writer->blocks[writer->front];
+        const std::size_t live = block.counts.back();
+        writer->bullets += live;
+        writer->tick++;
+        if (live * BZ_TRACE_BLOCK_TICKS > writer->capacity) {
+            writer->capacity = live * BZ_TRACE_BLOCK_TICKS;
+            bz::reserve_trace_block(&block, writer->capacity);
+        }
+        // Troca quando um tick do mesmo tamanho não caberia mais no bloco
+        if (block.ids.size() + live > writer->capacity) {
+            bz::swap_trace_blocks(writer);
+        }
+    }
+
+    /**
+     * Grava o que falta e fecha o arquivo
+    */
+    bool close_trace(trace_writer_t* writer) {
+        if (writer->file == NULL) {
+            return false;
+        }
+        if (!writer->blocks[writer->front].ticks.empty()) {
+            bz::swap_trace_blocks(writer);
+        }
+        {
+            std::lock_guard<std::mutex> lock(writer->mutex);
+            writer->closing = true;
+        }
+        writer->wake.notify_all();
+        writer->thread.join();
+        const bool ok = std::fclose(writer->file) == 0 && writer->ok;
+        writer->file = NULL;
+        return ok;
+    }
+
+    /**
+     * Leitura: o trace mapeado e a posição do próximo tick
+    */
+    typedef struct trace_view {
+        void* data = NULL;
+        std::size_t size = 0;
+        float scale = BZ_TRACE_SCALE;
+        std::size_t cursor = 0;
+        bool failed = false; // Tick truncado ou corrompido: a leitura para
+    } trace_view_t;
+
+    /**
+     * Um tick decodificado (os vetores são reaproveitados entre chamadas)
+    */
+    typedef struct trace_tick {
+        std::uint32_t tick = 0;
+        std::vector<std::uint32_t> ids;
+        std::vector<Vector2> positions;
+        std::vector<float> t;
+    } trace_tick_t;
+
+    void close_trace_view(trace_view_t* view) {
+        bz::unmap_file(view->data, view->size);
+        *view = trace_view_t{};
+    }
+
+    bool open_trace_view(const char* path, trace_view_t* view) {
+        *view = trace_view_t{};
+        if (!bz::map_file(path, &view->data, &view->size)) {
+            return false;
+        }
+        trace_header_t header;
+        if (view->size < sizeof(header)) {
+            close_trace_view(view);
+            return false;
+        }
+        std::memcpy(&header, view->data, sizeof(header));
+        if (header.magic != BZ_TRACE_MAGIC || header.version != BZ_TRACE_VERSION || header.scale == 0) {
+            std::fprintf(stderr, "bz::trace: arquivo inválido: %s\n", path);
+            close_trace_view(view);
+            return false;
+        }
+        view->scale = (float) header.scale;
+        view->cursor = sizeof(header);
+        #if !defined(_WIN32)
+            madvise(view->data, view->size, MADV_SEQUENTIAL);
+        #endif
+        return true;
+    }
+
+    bool get_varint(const std::uint8_t** p, const std::uint8_t* end, std::uint32_t* v) {
+        std::uint32_t value = 0;
+        for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+            const std::uint8_t byte = *(*p)++;
+            value |= (std::uint32_t) (byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                *v = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Decodifica uma coluna; on(i, v) recebe cada valor já sem o delta
+    */
+    template <typename Sink>
+    bool get_column(const std::uint8_t** p, const std::uint8_t* end, const std::uint32_t count, Sink on) {
+        std::int32_t previous = 0;
+        for (std::uint32_t i = 0; i < count; i++) {
+            std::uint32_t v;
+            if (!bz::get_varint(p, end, &v)) {
+                return false;
+            }
+            previous = (std::int32_t) ((std::uint32_t) previous + (std::uint32_t) bz::unzigzag(v));
+            on(i, previous);
+        }
+        return true;
+    }
+
+    /**
+     * Próximo tick, ou false no fim do arquivo (ou se view->failed)
+    */
+    bool next_tick(trace_view_t* view, trace_tick_t* out) {
+        if (view->failed || view->cursor == view->size) {
+            return false;
+        }
+        if (view->cursor + sizeof(trace_tick_header_t) > view->size) {
+            view->failed = true;
+            return false;
+        }
+        const std::uint8_t* base = (const std::uint8_t*) view->data;
+        trace_tick_header_t header;
+        std::memcpy(&header, base + view->cursor, sizeof(header));
+        const std::size_t begin = view->cursor + sizeof(header);
+        // Cada valor ocupa pelo menos 1 byte: count maior que isso é lixo
+        if (header.size > view->size - begin || header.count > header.size / 4) {
+            view->failed = true;
+            return false;
+        }
+        const std::uint8_t* p = base + begin;
+        const std::uint8_t* end = p + header.size;
+        out->tick = header.tick;
+        out->ids.resize(header.count);
+        out->positions.resize(header.count);
+        out->t.resize(header.count);
+        const float scale = 1.f / view->scale;
+        const bool ok =
+            bz::get_column(&p, end, header.count, [&](std::uint32_t i, std::int32_t v) { out->ids[i] = (std::uint32_t) v; }) &&
+            bz::get_column(&p, end, header.count, [&](std::uint32_t i, std::int32_t v) { out->positions[i].x = v * scale; }) &&
+            bz::get_column(&p, end, header.count, [&](std::uint32_t i, std::int32_t v) { out->positions[i].y = v * scale; }) &&
+            bz::get_column(&p, end, header.count, [&](std::uint32_t i, std::int32_t v) { out->t[i] = (std::uint16_t) v / 65535.f; });
+        if (!ok || p != end) {
+            view->failed = true;
+            return false;
+        }
+        view->cursor = begin + header.size;
+        return true;
+    }
+
+    void rewind_trace(trace_view_t* view) {
+        view->cursor = sizeof(trace_header_t);
+        view->failed = false;
+    }
+
+
+}  // namespace bz
+
+
+
+#endif
@@ -1,9 +1,23 @@
 #include "bezier.h"
+#include "bezier_template.h"
+#include "bezier_cohort.h"
+#include "bezier_power.h"
+#include "bezier_bake.h"
+#include "bezier_pattern.h"
+#include "bezier_svg.h"
+#include "bezier_raster.h"
+#include "bezier_capture.h"
+#include "bezier_trace.h"
+#include "bezier_snapshot.h"
+#include "platform.h"
+#include "scenario.h"
 #include <random>
 #include <array>
 #include <vector>
 #include <iostream>
-#include <queue>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
 
 
 #define SCREEN_WIDTH 1080
@@ -31,6 +45,9 @@
 #define MAIN_ENEMY_RADIUS 10.f
 #define MAIN_ENEMY_OFFSET 50.f
 
+#define WAVE_ARENA_SIZE 4096
+#define CURVE_POOL_LARGEST_BLOCK (4 << 20)
+
 
 std::default_random_engine generator;
 std::uniform_int_distribution<int> randEnemyNum(1, 5);
@@ -39,100 +56,350 @@ std::uniform_real_distribution<float> randXPos(0.f, (float) SCREEN_WIDTH);
 std::uniform_real_distribution<float> randYPos(0.f, (float) SCREEN_HEIGHT);
 
 
-std::vector<bz::bezier_animation_t> enemy_bullets;
-std::vector<bz::bezier_animation_t> special_bullets;
-std::vector<bz::bezier_animation_t> normal_bullets;
-bz::bezier_animation_t enemy_animation;
+// Curvas de vida longa e blocos extras das arenas das ondas; os blocos devolvidos
+// ficam no pool, então em regime nada volta a ir para o malloc
+std::pmr::unsynchronized_pool_resource curve_pool(
+    std::pmr::pool_options{0, CURVE_POOL_LARGEST_BLOCK}
+);
+
+
+/**
+ * Onda de bullets criados juntos. Os bullets e seus pontos de controle vêm de uma
+ * arena monotônica: criar é só avançar um ponteiro e, quando a onda inteira
+ * termina, um único release() devolve tudo.
+*/
+typedef struct wave {
+    std::byte buffer[WAVE_ARENA_SIZE];
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::vector<bz::bezier_animation_t> bullets;
+    wave* next = NULL;
+    wave() : arena(buffer, sizeof(buffer), &curve_pool), bullets(&arena) { }
+} wave_t;
+
+typedef struct bullet_group {
+    wave_t* waves = NULL; // Lista ligada das ondas ativas
+} bullet_group_t;
+
+std::vector<std::unique_ptr<wave_t>> wave_storage; // Dona de todas as ondas
+wave_t* free_waves = NULL;                         // Ondas recicladas
+
+
+// Bullets do inimigo com pontos fixos: curva compilada guardada no próprio bullet
+std::vector<bz::compiled_animation_t> enemy_bullets;
+bullet_group_t curve_bullets;  // grau alto demais para compilar (cenários)
+bullet_group_t homing_bullets; // só usados pelos cenários de estresse
+
+// Os tiros do jogador têm sempre a mesma forma: um modelo compartilhado + transformação
+bz::template_library_t templates;
+int normal_template = -1;
+int special_template = -1;
+std::vector<bz::template_animation_t> normal_bullets;
+std::vector<bz::template_animation_t> special_bullets;
+bz::bezier_animation_t enemy_animation(&curve_pool);
+// Com --svg o inimigo segue um caminho importado (amostrado, pode ter vários segmentos)
+bz::bake_library_t svg_paths;
+int enemy_svg_path = -1;
 
 Vector2 player_pos;
 
 double player_timer = 0.0;
 double enemy_timer = 0.0;
 
+// Padrão carregado com --pattern: substitui os tiros sorteados do inimigo
+bz::pattern_view_t pattern;
+bz::spawn_stream_t pattern_stream;
+
+// Rollback (--snapshots N): o estado inteiro é salvo a cada frame num anel de N snapshots
+bz::snapshot_ring_t snapshots;
+bool snapshots_enabled = false;
+std::uint64_t sim_frame = 0;
+
+scenario::spawner_t stress;
+scenario::timings_t timings;
+bool stress_enabled = false;
+scenario::timings_t* pTimings = NULL; // != NULL quando os tempos por fase são coletados
+// O cenário ou o padrão mistura easings: os bullets compilados levam o easing dentro da curva
+bool compose_easings = false;
+
+
+/**
+ * Pega uma onda livre (ou cria uma) com espaço para n bullets e a coloca no grupo
+*/
+wave_t* new_wave(bullet_group_t* group, const std::size_t n) {
+    wave_t* wave = free_waves;
+    if (wave != NULL) {
+        free_waves = wave->next;
+    } else {
+        wave_storage.push_back(std::make_unique<wave_t>());
+        wave = wave_storage.back().get();
+    }
+    wave->bullets.reserve(n);
+    wave->next = group->waves;
+    group->waves = wave;
+    return wave;
+}
+
+/**
+ * Devolve a arena da onda de uma vez e a coloca na lista de ondas livres
+*/
+void release_wave(wave_t* wave) {
+    // Troca por um vetor vazio da mesma arena: o buffer antigo some junto com o release()
+    std::pmr::vector<bz::bezier_animation_t>(&wave->arena).swap(wave->bullets);
+    wave->arena.release();
+    wave->next = free_waves;
+    free_waves = wave;
+}
+
+std::size_t group_size(const bullet_group_t* group) {
+    std::size_t n = 0;
+    for (const wave_t* w = group->waves; w != NULL; w = w->next) {
+        n += w->bullets.size();
+    }
+    return n;
+}
+
 
 void create_enemy_bullets() {
     if (enemy_timer >= ENEMY_ATTACK_SPEED) {
         enemy_timer = 0.0;
         const int n = randEnemyNum(generator);
         for (int i = 0; i < n; i++) {
-            bz::bezier_animation_t animation = {};
+            bz::compiled_animation_t& animation = enemy_bullets.emplace_back();
             animation.time_to_complete = 8.f;            
-            animation.control_points.push_back(enemy_animation.C);
-            animation.control_points.push_back({randXPos(generator), randYPos(generator)});
-            animation.control_points.push_back({player_pos.x, player_pos.y + SCREEN_HEIGHT});
-            enemy_bullets.push_back(animation);
+            const Vector2 points[3] = {
+                enemy_animation.C,
+                {randXPos(generator), randYPos(generator)},
+                {player_pos.x, player_pos.y + SCREEN_HEIGHT}
+            };
+            bz::compile_animation(points, 3, &animation);
         }
     }
 }
 
 
+bool pattern_mixes_easings(const bz::pattern_view_t& view) {
+    for (std::uint32_t i = 1; view.header != NULL && i < view.header->curve_count; i++) {
+        if (view.curves[i].t_function != view.curves[0].t_function) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * Cria de uma vez os spawns do padrão que venceram neste tick. Os pontos são
+ * relativos à posição atual do inimigo; as curvas longas demais para compilar
+ * vão para uma onda.
+*/
+void create_pattern_bullets(const float dt) {
+    std::uint32_t first, last;
+    const std::uint32_t n = bz::next_spawns(&pattern_stream, dt, &first, &last);
+    if (n == 0) {
+        return;
+    }
+    enemy_bullets.reserve(enemy_bullets.size() + n);
+    wave_t* wave = NULL;
+    Vector2 points[BZ_POWER_MAX_DEGREE + 1];
+    for (std::uint32_t s = first; s < last; s++) {
+        const bz::pattern_spawn_t& spawn = pattern.spawns[s];
+        const bz::pattern_curve_t& curve = pattern.curves[spawn.curve];
+        const Vector2* source = bz::curve_points(pattern, spawn.curve);
+        const Vector2 origin = {enemy_animation.C.x + spawn.x, enemy_animation.C.y + spawn.y};
+        bz::animation_state_t state{};
+        state.time_to_complete = curve.time_to_complete;
+        state.t_function = (bz::TBasicFunction) curve.t_function;
+        state.loop = (curve.flags & BZ_PATTERN_LOOP) != 0;
+        if (curve.point_count <= BZ_POWER_MAX_DEGREE + 1) {
+            for (std::uint32_t i = 0; i < curve.point_count; i++) {
+                points[i] = Vector2Add(source[i], origin);
+            }
+            bz::compiled_animation_t& animation = enemy_bullets.emplace_back();
+            static_cast<bz::animation_state_t&>(animation) = state;
+            bz::compile_animation(points, curve.point_count, &animation, compose_easings);
+            continue;
+        }
+        if (wave == NULL) {
+            wave = new_wave(&curve_bullets, last - s);
+        }
+        bz::bezier_animation_t& animation = wave->bullets.emplace_back();
+        static_cast<bz::animation_state_t&>(animation) = state;
+        for (std::uint32_t i = 0; i < curve.point_count; i++) {
+            animation.control_points.push_back(Vector2Add(source[i], origin));
+        }
+    }
+}
+
+
+/**
+ * Cria os bullets do cenário de estresse. Com prefill o time_count é sorteado
+ * para que a densidade de regime já exista no primeiro frame.
+ * Os que não seguem o jogador são compilados; os de grau alto demais para a
+ * base de potências e os teleguiados vão para as ondas.
+*/
+void create_scenario_bullets(const int n, const bool prefill) {
+    if (n <= 0) {
+        return;
+    }
+    const int homing = scenario::homing_count(&stress, n);
+    wave_t* waves[2] = {NULL, homing > 0 ? new_wave(&homing_bullets, homing) : NULL};
+    Vector2 points[SCENARIO_MAX_DEGREE + 1];
+    for (int i = 0; i < n; i++) {
+        bz::animation_state_t state{};
+        const int count = scenario::make_curve(
+            &stress, points, &state, enemy_animation.C, player_pos, SCREEN_RECT
+        );
+        if (prefill) {
+            state.time_count = stress.unit(stress.rng) * state.time_to_complete;
+        }
+        if (i >= homing) {
+            bz::compiled_animation_t compiled{};
+            static_cast<bz::animation_state_t&>(compiled) = state;
+            if (bz::compile_animation(points, count, &compiled, compose_easings)) {
+                enemy_bullets.push_back(compiled);
+                continue;
+            }
+            if (waves[0] == NULL) {
+                waves[0] = new_wave(&curve_bullets, n - i);
+            }
+        }
+        bz::bezier_animation_t& animation = waves[i < homing ? 1 : 0]->bullets.emplace_back();
+        static_cast<bz::animation_state_t&>(animation) = state;
+        animation.control_points.assign(points, points + count);
+    }
+    // Agrupa por grau e easing para que cada coorte fique contígua na onda
+    for (wave_t* wave : waves) {
+        if (wave != NULL && !prefill) {
+            std::sort(
+                wave->bullets.begin(),
+                wave->bullets.end(),
+                [](const bz::bezier_animation_t& l, const bz::bezier_animation_t& r) {
+                    return l.control_points.size() != r.control_points.size()
+                        ? l.control_points.size() < r.control_points.size()
+                        : l.t_function < r.t_function;
+                }
+            );
+        }
+    }
+}
+
+
+void create_templates() {
+    // normal: reta vertical; a escala em y leva o ponto final até y = -100
+    normal_template = bz::add_template(&templates, {{20.f, 0.f}, {20.f, 1.f}});
+    // special: o último ponto é trocado pelo alvo a cada frame
+    special_template = bz::add_template(&templates, {{100.f, -20.f}, {500.f, -200.f}, {0.f, 0.f}});
+}
+
+
 void create_player_bullets() {
     if (player_timer >= PLAYER_ATTACK_SPEED) {
         player_timer = 0.0;
         std::array<int, 2> directions = {-1, 1};
-        bz::bezier_animation_t animation;
-        animation.time_to_complete = 2.0f;
         for (int d : directions) {
             // normal bullet
-            animation.control_points.clear();
-            animation.control_points.push_back(
-                {player_pos.x + 20 * d, player_pos.y - 20}
+            bz::template_animation_t& animation = normal_bullets.emplace_back();
+            animation.time_to_complete = 2.0f;
+            animation.template_id = normal_template;
+            animation.transform = bz::make_transform(
+                {(float) d, -100.f - (player_pos.y - 20)},
+                {player_pos.x, player_pos.y - 20}
             );
-            animation.control_points.push_back(
-                {player_pos.x + 20 * d, -100}
-            );            
-            normal_bullets.push_back(animation);
             // special bullet
-            animation.control_points.clear();
-            animation.control_points.push_back({player_pos.x + 100 * d, player_pos.y - 20});
-            animation.control_points.push_back({player_pos.x + 500 * d, player_pos.y - 200});
-            animation.control_points.push_back({0.f, 0.f});  
-            special_bullets.push_back(animation);
+            bz::template_animation_t& special_animation = special_bullets.emplace_back();
+            special_animation.time_to_complete = 2.0f;
+            special_animation.template_id = special_template;
+            special_animation.transform = bz::make_transform({(float) d, 1.f}, player_pos);
+            special_animation.follows_target = true;
         }                
     }
 }
 
 
+/**
+ * Remove as animações completas compactando no lugar
+*/
+template <typename Container>
+void remove_completed(Container* animations) {
+    animations->erase(
+        std::remove_if(
+            animations->begin(),
+            animations->end(),
+            [](const bz::animation_state_t& a) { return a.time_count >= a.time_to_complete; }
+        ),
+        animations->end()
+    );
+}
+
+
+void update_compiled_bullets(std::vector<bz::compiled_animation_t>* bullets, const float dt) {
+    BZ_PROFILE_ZONE("update_compiled_bullets");
+    for (bz::compiled_animation_t& a : *bullets) {
+        bz::animation_update(&a, dt);
+    }
+}
+
+
+void update_template_bullets(
+    std::vector<bz::template_animation_t>* bullets,
+    const float dt,
+    Vector2* target
+) {
+    BZ_PROFILE_ZONE("update_template_bullets");
+    if (target != NULL) {
+        for (bz::template_animation_t& a : *bullets) {
+            a.end = *target;
+        }
+    }
+    bz::animation_update(&templates, bullets->data(), bullets->size(), dt);
+}
+
+
 void update_bullets(
-    std::vector<bz::bezier_animation_t>* bullets,
+    bullet_group_t* bullets,
     const float dt,
     Vector2* target
 ) {
-   for (bz::bezier_animation_t& a : *bullets) {
-        bz::bezier_animation_t* pA = std::addressof(a);
+   BZ_PROFILE_ZONE("update_bullets");
+   for (wave_t* w = bullets->waves; w != NULL; w = w->next) {
         if (target != NULL) { 
-            bz::change_end_point(pA, *target);
+            for (bz::bezier_animation_t& a : w->bullets) {
+                bz::change_end_point(std::addressof(a), *target);
+            }
         }
-        bz::animation_update(pA, dt);
+        // Bullets da mesma onda foram criados no mesmo tick: uma base por coorte
+        bz::cohort_update(w->bullets.data(), w->bullets.size(), dt);
    } 
 }
 
 
-void handle_offscreen_bullets(std::vector<bz::bezier_animation_t>* bullets) {
-    std::queue<int> q;
-    for (int i = 0; i < bullets->size(); i++) {
-        bz::bezier_animation_t& a = bullets->at(i);
-        if (a.time_count >= a.time_to_complete) {
-            q.push(i);
+void handle_offscreen_bullets(bullet_group_t* bullets) {
+    BZ_PROFILE_ZONE("handle_offscreen_bullets");
+    wave_t** link = &bullets->waves;
+    while (*link != NULL) {
+        wave_t* w = *link;
+        // Compacta dentro da onda: mesma arena, então mover não aloca
+        remove_completed(&w->bullets);
+        if (w->bullets.empty()) {
+            *link = w->next;
+            release_wave(w);
+        } else {
+            link = &w->next;
         }
     }
-    while (q.empty() == false) {        
-        bullets->erase(bullets->begin() + q.front());
-        q.pop();
-    }
 }
 
 void update_player(const float dt) {
-    const float speed = IsKeyDown(KEY_LEFT_SHIFT) ? PLAYER_SLOW_SPEED * dt : PLAYER_SPEED * dt;
+    const float speed = platform::key_down(KEY_LEFT_SHIFT) ? PLAYER_SLOW_SPEED * dt : PLAYER_SPEED * dt;
     Vector2 direction = {0.f, 0.f};
-    if (IsKeyDown(KEY_LEFT)) {
+    if (platform::key_down(KEY_LEFT)) {
         direction.x = -1;
-    } else if (IsKeyDown(KEY_RIGHT)) {
+    } else if (platform::key_down(KEY_RIGHT)) {
         direction.x = 1;
     }
-    if (IsKeyDown(KEY_UP)) {
+    if (platform::key_down(KEY_UP)) {
         direction.y = -1;
-    } else if (IsKeyDown(KEY_DOWN)) {
+    } else if (platform::key_down(KEY_DOWN)) {
         direction.y = 1;
     }
     direction = Vector2Normalize(direction);
@@ -140,63 +407,540 @@ void update_player(const float dt) {
     player_pos.y += direction.y * speed;
 }
 
+/**
+ * Avaliação direta: com um caminho só, a tabela amostrada não compensa
+ * (benchmark "bake", caso compartilhado)
+*/
+void update_enemy(const float dt) {
+    if (enemy_svg_path < 0) {
+        bz::animation_update(&enemy_animation, dt);
+        return;
+    }
+    bz::advance_time(&enemy_animation, dt);
+    enemy_animation.C = bz::sample_baked_path(svg_paths.paths[enemy_svg_path], enemy_animation.t);
+}
+
 void update(const float dt) {
-    bz::animation_update(&enemy_animation, dt);
+    update_enemy(dt);
     update_player(dt);
-    create_enemy_bullets();
-    create_player_bullets();
-    update_bullets(&normal_bullets, dt, NULL);
-    update_bullets(&enemy_bullets, dt, NULL);
-    update_bullets(&special_bullets, dt, &enemy_animation.C);
-    handle_offscreen_bullets(&normal_bullets);
-    handle_offscreen_bullets(&enemy_bullets);
-    handle_offscreen_bullets(&special_bullets);
+    {
+        scenario::phase_timer_t timer(pTimings, scenario::TPhase::Spawn);
+        BZ_PROFILE_ZONE("spawn");
+        if (stress_enabled) {
+            create_scenario_bullets(scenario::spawn_count(&stress, dt), false);
+        } else if (pattern.header != NULL) {
+            create_pattern_bullets(dt);
+        } else {
+            create_enemy_bullets();
+        }
+        create_player_bullets();
+    }
+    {
+        scenario::phase_timer_t timer(pTimings, scenario::TPhase::Update);
+        BZ_NO_ALLOC_REGION("update");
+        update_template_bullets(&normal_bullets, dt, NULL);
+        update_compiled_bullets(&enemy_bullets, dt);
+        update_bullets(&curve_bullets, dt, NULL);
+        update_template_bullets(&special_bullets, dt, &enemy_animation.C);
+        update_bullets(&homing_bullets, dt, &player_pos);
+    }
+    {
+        scenario::phase_timer_t timer(pTimings, scenario::TPhase::Cleanup);
+        BZ_NO_ALLOC_REGION("cleanup");
+        remove_completed(&normal_bullets);
+        remove_completed(&enemy_bullets);
+        handle_offscreen_bullets(&curve_bullets);
+        remove_completed(&special_bullets);
+        handle_offscreen_bullets(&homing_bullets);
+    }
 }
 
+int live_bullets() {
+    return normal_bullets.size() + special_bullets.size() +
+        enemy_bullets.size() + group_size(&curve_bullets) + group_size(&homing_bullets);
+}
 
-void draw() {
-    for (bz::bezier_animation_t& a : normal_bullets) {
-        DrawCircleV(a.C, BULLET_RADIUS, PLAYER_NORMAL_BULLET_COLOR);
+
+/**
+ * Estado de todos os bullets no tick, para --bullet-trace
+*/
+void trace_bullets(bz::trace_writer_t* trace) {
+    BZ_PROFILE_ZONE("trace_bullets");
+    bz::begin_tick(trace);
+    bz::trace_bullets(trace, normal_bullets.data(), normal_bullets.size());
+    bz::trace_bullets(trace, special_bullets.data(), special_bullets.size());
+    bz::trace_bullets(trace, enemy_bullets.data(), enemy_bullets.size());
+    for (bullet_group_t* group : {&curve_bullets, &homing_bullets}) {
+        for (wave_t* w = group->waves; w != NULL; w = w->next) {
+            bz::trace_bullets(trace, w->bullets.data(), w->bullets.size());
+        }
     }
-    for (bz::bezier_animation_t& a : special_bullets) {
-        DrawCircleV(a.C, BULLET_RADIUS, PLAYER_SPECIAL_BULLET_COLOR);
+    bz::end_tick(trace);
+}
+
+
+template <typename Animation>
+std::uint32_t hash_animations(std::uint32_t hash, const Animation* animations, const std::size_t count) {
+    hash = platform::hash_bytes(hash, &count, sizeof(count));
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint32_t xy[2];
+        std::memcpy(xy, &animations[i].C, sizeof(xy));
+        hash = platform::hash_word(platform::hash_word(hash, xy[0]), xy[1]);
     }
-    for (bz::bezier_animation_t& a : enemy_bullets) {
-        DrawCircleV(a.C, BULLET_RADIUS, ENEMY_BULLET_COLOR);
+    return hash;
+}
+
+/**
+ * Hash das posições de tudo no fim do tick (--record/--replay): o replay
+ * acusa o primeiro frame em que a simulação deixou de ser a gravada
+*/
+std::uint32_t state_checksum() {
+    BZ_PROFILE_ZONE("state_checksum");
+    std::uint32_t hash = 2166136261u;
+    hash = platform::hash_bytes(hash, &player_pos, sizeof(player_pos));
+    hash = platform::hash_bytes(hash, &enemy_animation.C, sizeof(enemy_animation.C));
+    hash = hash_animations(hash, normal_bullets.data(), normal_bullets.size());
+    hash = hash_animations(hash, special_bullets.data(), special_bullets.size());
+    hash = hash_animations(hash, enemy_bullets.data(), enemy_bullets.size());
+    for (const bullet_group_t* group : {&curve_bullets, &homing_bullets}) {
+        for (const wave_t* w = group->waves; w != NULL; w = w->next) {
+            hash = hash_animations(hash, w->bullets.data(), w->bullets.size());
+        }
     }
+    return hash | 1; // 0 fica para "sem checksum"
+}
+
+
+/**
+ * Tudo que não é bullet, copiado de uma vez para o snapshot. As distribuições
+ * não guardam estado entre sorteios, então bastam os geradores.
+*/
+typedef struct world_scalars {
+    std::uint64_t frame;
+    Vector2 player_pos;
+    double player_timer;
+    double enemy_timer;
+    bz::animation_state_t enemy_state; // Os pontos de controle do inimigo não mudam
+    std::default_random_engine generator;
+    std::mt19937 stress_rng;
+    double stress_accumulator;
+    double stress_homing_accumulator;
+    bz::spawn_stream_t pattern_stream;
+} world_scalars_t;
+
+/**
+ * Os bullets das ondas têm os pontos de controle na arena: no snapshot eles
+ * viram colunas planas (reaproveitadas entre frames)
+*/
+typedef struct group_columns {
+    std::vector<std::uint32_t> wave_sizes; // Na ordem da lista ligada
+    std::vector<bz::animation_state_t> states;
+    std::vector<std::uint32_t> point_counts;
+    std::vector<Vector2> points;
+} group_columns_t;
+
+group_columns_t group_columns;
+
+
+void save_group(bz::snapshot_writer_t* writer, const bullet_group_t* group) {
+    group_columns_t& c = group_columns;
+    c.wave_sizes.clear();
+    c.states.clear();
+    c.point_counts.clear();
+    c.points.clear();
+    for (const wave_t* w = group->waves; w != NULL; w = w->next) {
+        c.wave_sizes.push_back(w->bullets.size());
+        for (const bz::bezier_animation_t& a : w->bullets) {
+            c.states.push_back(a);
+            c.point_counts.push_back(a.control_points.size());
+            c.points.insert(c.points.end(), a.control_points.begin(), a.control_points.end());
+        }
+    }
+    bz::save_array(writer, c.wave_sizes);
+    bz::save_array(writer, c.states);
+    bz::save_array(writer, c.point_counts);
+    bz::save_array(writer, c.points);
+}
+
+void load_group(bz::snapshot_reader_t* reader, bullet_group_t* group) {
+    group_columns_t& c = group_columns;
+    bz::load_array(reader, &c.wave_sizes);
+    bz::load_array(reader, &c.states);
+    bz::load_array(reader, &c.point_counts);
+    bz::load_array(reader, &c.points);
+    while (group->waves != NULL) {
+        wave_t* w = group->waves;
+        group->waves = w->next;
+        release_wave(w);
+    }
+    // new_wave insere no começo da lista: as ondas são recriadas da última para a primeira
+    std::size_t bullet = c.states.size();
+    std::size_t point = c.points.size();
+    for (std::size_t i = c.wave_sizes.size(); i-- > 0;) {
+        wave_t* wave = new_wave(group, c.wave_sizes[i]);
+        bullet -= c.wave_sizes[i];
+        std::size_t first_point = point;
+        for (std::size_t b = bullet; b < bullet + c.wave_sizes[i]; b++) {
+            first_point -= c.point_counts[b];
+        }
+        point = first_point;
+        for (std::size_t b = bullet; b < bullet + c.wave_sizes[i]; b++) {
+            bz::bezier_animation_t& animation = wave->bullets.emplace_back();
+            static_cast<bz::animation_state_t&>(animation) = c.states[b];
+            animation.control_points.assign(c.points.begin() + first_point, c.points.begin() + first_point + c.point_counts[b]);
+            first_point += c.point_counts[b];
+        }
+    }
+}
+
+void save_world() {
+    BZ_PROFILE_ZONE("save_world");
+    bz::snapshot_writer_t writer = bz::begin_snapshot(&snapshots, sim_frame);
+    const world_scalars_t scalars = {
+        sim_frame, player_pos, player_timer, enemy_timer, static_cast<const bz::animation_state_t&>(enemy_animation), generator,
+        stress.rng, stress.accumulator, stress.homing_accumulator, pattern_stream
+    };
+    bz::save_value(&writer, scalars);
+    bz::save_array(&writer, normal_bullets);
+    bz::save_array(&writer, special_bullets);
+    bz::save_array(&writer, enemy_bullets);
+    save_group(&writer, &curve_bullets);
+    save_group(&writer, &homing_bullets);
+    bz::end_snapshot(&writer);
+}
+
+void load_world(const bz::snapshot_t* snapshot) {
+    BZ_PROFILE_ZONE("load_world");
+    bz::snapshot_reader_t reader = bz::read_snapshot(snapshot);
+    world_scalars_t scalars;
+    bz::load_value(&reader, &scalars);
+    sim_frame = scalars.frame;
+    player_pos = scalars.player_pos;
+    player_timer = scalars.player_timer;
+    enemy_timer = scalars.enemy_timer;
+    static_cast<bz::animation_state_t&>(enemy_animation) = scalars.enemy_state;
+    generator = scalars.generator;
+    stress.rng = scalars.stress_rng;
+    stress.accumulator = scalars.stress_accumulator;
+    stress.homing_accumulator = scalars.stress_homing_accumulator;
+    pattern_stream = scalars.pattern_stream;
+    bz::load_array(&reader, &normal_bullets);
+    bz::load_array(&reader, &special_bullets);
+    bz::load_array(&reader, &enemy_bullets);
+    load_group(&reader, &curve_bullets);
+    load_group(&reader, &homing_bullets);
+}
+
+/**
+ * Volta um snapshot (BACKSPACE segurado com --snapshots). Retorna false se
+ * não há snapshot mais antigo.
+*/
+bool rewind_world() {
+    if (snapshots.last == NULL) {
+        return false;
+    }
+    const bz::snapshot_t* previous = bz::find_snapshot(snapshots, snapshots.last->frame - 1);
+    if (previous == NULL || snapshots.last->frame == 0) {
+        return false;
+    }
+    load_world(previous);
+    bz::rewind_ring(&snapshots, previous);
+    return true;
+}
+
+
+void draw_bullets(const bullet_group_t* bullets, const Color color) {
+    for (const wave_t* w = bullets->waves; w != NULL; w = w->next) {
+        for (const bz::bezier_animation_t& a : w->bullets) {
+            DrawCircleV(a.C, BULLET_RADIUS, color);
+        }
+    }
+}
+
+
+template <typename Animation>
+void draw_animations(const std::vector<Animation>* bullets, const Color color) {
+    for (const Animation& a : *bullets) {
+        DrawCircleV(a.C, BULLET_RADIUS, color);
+    }
+}
+
+
+void draw() {
+    BZ_PROFILE_ZONE("draw");
+    draw_animations(&normal_bullets, PLAYER_NORMAL_BULLET_COLOR);
+    draw_animations(&special_bullets, PLAYER_SPECIAL_BULLET_COLOR);
+    draw_animations(&enemy_bullets, ENEMY_BULLET_COLOR);
+    draw_bullets(&curve_bullets, ENEMY_BULLET_COLOR);
+    draw_bullets(&homing_bullets, ENEMY_BULLET_COLOR);
     DrawCircleV(enemy_animation.C, ENEMY_RADIUS, ENEMY_COLOR);
     DrawCircleV(player_pos, PLAYER_RADIUS, PLAYER_COLOR);
 }
 
 
+void raster_bullets(bz::rasterizer_t* r, const bullet_group_t* bullets, const Color color) {
+    for (const wave_t* w = bullets->waves; w != NULL; w = w->next) {
+        for (const bz::bezier_animation_t& a : w->bullets) {
+            bz::raster_circle(r, a.C, BULLET_RADIUS, color);
+        }
+    }
+}
+
+
+template <typename Animation>
+void raster_animations(bz::rasterizer_t* r, const std::vector<Animation>* bullets, const Color color) {
+    for (const Animation& a : *bullets) {
+        bz::raster_circle(r, a.C, BULLET_RADIUS, color);
+    }
+}
+
+
+/**
+ * O mesmo que draw(), no rasterizador em CPU (headless com --render)
+*/
+void draw_cpu(bz::rasterizer_t* r, Image* frame) {
+    BZ_PROFILE_ZONE("draw_cpu");
+    bz::begin_raster(r, frame->width, frame->height);
+    raster_animations(r, &normal_bullets, PLAYER_NORMAL_BULLET_COLOR);
+    raster_animations(r, &special_bullets, PLAYER_SPECIAL_BULLET_COLOR);
+    raster_animations(r, &enemy_bullets, ENEMY_BULLET_COLOR);
+    raster_bullets(r, &curve_bullets, ENEMY_BULLET_COLOR);
+    raster_bullets(r, &homing_bullets, ENEMY_BULLET_COLOR);
+    bz::raster_circle(r, enemy_animation.C, ENEMY_RADIUS, ENEMY_COLOR);
+    bz::raster_circle(r, player_pos, PLAYER_RADIUS, PLAYER_COLOR);
+    ImageClearBackground(frame, WINDOW_COLOR);
+    bz::rasterize(r, frame);
+}
+
+
+
+
+// Roteiro padrão do modo headless: o jogador desvia para os lados e sobe/desce
+#define HEADLESS_SCRIPT \
+    "0 key LEFT down\n" \
+    "90 key LEFT up\n" \
+    "90 key RIGHT down\n" \
+    "100 key LEFT_SHIFT down\n" \
+    "180 key LEFT_SHIFT up\n" \
+    "270 key RIGHT up\n" \
+    "270 key UP down\n" \
+    "330 key UP up\n" \
+    "330 key DOWN down\n" \
+    "390 key DOWN up\n"
 
 
 int main(int argc, char const *argv[]) {
-    SetConfigFlags(FLAG_VSYNC_HINT);
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_TITLE);        
+    const platform::options_t options = platform::parse_args(argc, argv);
+    const char* timings_path = NULL;
+    const char* svg_path = NULL;
+    double svg_tolerance = BZ_BAKE_TOLERANCE;
+    const char* render_path = NULL;
+    const char* gif_path = NULL;
+    const char* trace_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--alloc-trap") == 0) {
+            bz::alloc::set_trap(true);
+        } else if (std::strcmp(argv[i], "--report") == 0) {
+            pTimings = &timings;
+        } else if (i + 1 >= argc) {
+            break;
+        } else if (std::strcmp(argv[i], "--scenario") == 0) {
+            scenario::scenario_t desc;
+            if (!scenario::parse(argv[++i], &desc)) {
+                return 1;
+            }
+            scenario::init_spawner(&stress, desc);
+            stress_enabled = true;
+            pTimings = &timings;
+        } else if (std::strcmp(argv[i], "--timings") == 0) {
+            timings_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--pattern") == 0) {
+            if (!bz::open_pattern(argv[++i], &pattern)) {
+                std::cerr << "não foi possível abrir o padrão " << argv[i] << std::endl;
+                return 1;
+            }
+            bz::open_stream(&pattern_stream, &pattern);
+        } else if (std::strcmp(argv[i], "--svg") == 0) {
+            svg_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--svg-tolerance") == 0) {
+            svg_tolerance = std::atof(argv[++i]);
+            if (!(svg_tolerance > 0.0)) {
+                std::cerr << "tolerância do SVG inválida: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--render") == 0) {
+            render_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--gif") == 0) {
+            gif_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--bullet-trace") == 0) {
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--snapshots") == 0) {
+            bz::init_snapshot_ring(&snapshots, std::max(2, std::atoi(argv[++i])));
+            snapshots_enabled = true;
+        }
+    }
+    platform::init(options, SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_TITLE, HEADLESS_SCRIPT);
+    // Mesma semente na gravação e no replay (--seed / --record / --replay)
+    generator.seed((std::default_random_engine::result_type) platform::seed());
+    create_templates();
     enemy_animation.control_points.push_back({MAIN_ENEMY_OFFSET, MAIN_ENEMY_OFFSET});
     enemy_animation.control_points.push_back({SCREEN_WIDTH / 2.f, SCREEN_HEIGHT / 2.f});
     enemy_animation.control_points.push_back({SCREEN_WIDTH - MAIN_ENEMY_OFFSET, MAIN_ENEMY_OFFSET});
     enemy_animation.time_to_complete = 9.0;
     enemy_animation.loop = true;
     enemy_animation.t_function = bz::TBasicFunction::Parabola;
+    compose_easings = stress_enabled ? scenario::mixes_easings(stress.desc) : pattern_mixes_easings(pattern);
+    if (svg_path != NULL) {
+        // Trajetória do inimigo desenhada num editor vetorial: o caminho com id "enemy", ou o primeiro
+        bz::svg_cache_t svg_cache;
+        const bz::svg_cache_entry_t* svg = bz::import_svg(&svg_cache, &svg_paths, svg_path, svg_tolerance);
+        if (svg == NULL || svg->document.paths.empty()) {
+            std::cerr << "não foi possível importar " << svg_path << std::endl;
+            platform::close();
+            bz::close_pattern(&pattern);
+            return 1;
+        }
+        enemy_svg_path = svg->first_path + std::max(0, bz::find_svg_path(svg->document, "enemy"));
+    }
     
     player_pos = {
         SCREEN_WIDTH / 2.0 - PLAYER_RADIUS / 2.0, 
         SCREEN_HEIGHT - 50.0
     };    
 
-    while (!WindowShouldClose()) {
-        const float dt = GetFrameTime();
+    if (pTimings != NULL) {
+        scenario::reserve(pTimings, options.headless ? options.frames : 0);
+    }
+    if (stress_enabled) {
+        update_enemy(0.f);
+        create_scenario_bullets(stress.desc.bullets, true);
+    }
+
+    // Headless com --render/--gif: cada frame é desenhado em CPU (o último é salvo com --render)
+    bz::rasterizer_t rasterizer;
+    Image frame{};
+    if ((render_path != NULL || gif_path != NULL) && platform::is_headless()) {
+        frame = GenImageColor(SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_COLOR);
+    }
+    bz::gif_recorder_t gif;
+    if (gif_path != NULL && !bz::begin_gif(&gif, gif_path, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        std::cerr << "não foi possível gravar " << gif_path << std::endl;
+        if (frame.data != NULL) {
+            UnloadImage(frame);
+        }
+        platform::close();
+        bz::close_pattern(&pattern);
+        return 1;
+    }
+    bz::trace_writer_t bullet_trace;
+    if (trace_path != NULL && !bz::open_trace(&bullet_trace, trace_path)) {
+        std::cerr << "não foi possível gravar " << trace_path << std::endl;
+        if (bz::is_recording(gif)) {
+            bz::end_gif(&gif);
+        }
+        if (frame.data != NULL) {
+            UnloadImage(frame);
+        }
+        platform::close();
+        bz::close_pattern(&pattern);
+        return 1;
+    }
+
+    while (!platform::should_close()) {
+        platform::begin_frame();
+        const float dt = platform::frame_time();
+        bool rewound = false;
+        if (snapshots_enabled && platform::key_down(KEY_BACKSPACE)) {
+            // Voltando no tempo: o frame mostra o estado restaurado, sem simular
+            scenario::phase_timer_t timer(pTimings, scenario::TPhase::Snapshot);
+            rewound = rewind_world();
+        }
+        if (!rewound) {
             player_timer += dt;
             enemy_timer += dt;    
             update(dt);
-        BeginDrawing();
-        ClearBackground(WINDOW_COLOR);
-            draw();
-        EndDrawing();
+            sim_frame++;
+            if (platform::is_recording() || platform::is_replaying()) {
+                platform::check_state(state_checksum());
+            }
+            if (bz::is_tracing(bullet_trace)) {
+                trace_bullets(&bullet_trace);
+            }
+            if (snapshots_enabled) {
+                scenario::phase_timer_t timer(pTimings, scenario::TPhase::Snapshot);
+                save_world();
+            }
+        }
+        if (platform::is_headless()) {
+            if (frame.data != NULL) {
+                scenario::phase_timer_t timer(pTimings, scenario::TPhase::Draw);
+                draw_cpu(&rasterizer, &frame);
+                if (bz::is_recording(gif)) {
+                    // Offline: espera a encoder em vez de perder frames
+                    bz::capture_frame(&gif, frame.data, dt, true);
+                }
+            }
+        } else {
+            BeginDrawing();
+            ClearBackground(WINDOW_COLOR);
+            {
+                scenario::phase_timer_t timer(pTimings, scenario::TPhase::Draw);
+                draw();
+                if (bz::is_recording(gif)) {
+                    bz::capture_screen(&gif, dt);
+                }
+            }
+            EndDrawing();
+        }
+        if (pTimings != NULL) {
+            scenario::end_frame(pTimings, live_bullets());
+        }
     }
 
-    CloseWindow();
+    if (bz::is_recording(gif)) {
+        const int dropped = gif.dropped;
+        const int frames = gif.frames;
+        if (!bz::end_gif(&gif)) {
+            std::cerr << "não foi possível gravar " << gif_path << std::endl;
+        }
+        std::printf("gif: %d frames gravados, %d descartados (anel cheio)\n", frames, dropped);
+    }
+    if (snapshots_enabled && snapshots.last != NULL) {
+        // Ida e volta do último snapshot: o estado restaurado tem de ser o mesmo
+        const std::uint32_t before = state_checksum();
+        load_world(snapshots.last);
+        std::printf(
+            "snapshots: %.1f MB em páginas, último com %zu páginas copiadas e %zu compartilhadas, restauração %s\n",
+            bz::snapshot_memory(snapshots) / 1048576.0, snapshots.copied, snapshots.shared,
+            state_checksum() == before ? "idêntica" : "DIVERGENTE"
+        );
+    }
+    if (bz::is_tracing(bullet_trace)) {
+        if (!bz::close_trace(&bullet_trace)) {
+            std::cerr << "não foi possível gravar " << trace_path << std::endl;
+        }
+        std::printf(
+            "trace: %u ticks, %llu bullets, %.2f bytes/bullet, %d esperas da escritora\n",
+            bullet_trace.tick, (unsigned long long) bullet_trace.bullets,
+            bullet_trace.bullets > 0 ? (double) bullet_trace.bytes / bullet_trace.bullets : 0.0,
+            bullet_trace.stalls
+        );
+    }
+    if (frame.data != NULL && render_path != NULL) {
+        if (!ExportImage(frame, render_path)) {
+            std::cerr << "não foi possível gravar " << render_path << std::endl;
+        }
+    }
+    if (frame.data != NULL) {
+        UnloadImage(frame);
+    }
+    platform::close();
+    bz::close_pattern(&pattern);
+    if (pTimings != NULL) {
+        scenario::report(timings, stdout);
+        if (timings_path != NULL && !scenario::write_csv(timings, timings_path)) {
+            std::cerr << "não foi possível gravar " << timings_path << std::endl;
+        }
+    }
 
 }
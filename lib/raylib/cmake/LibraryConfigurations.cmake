@@ -91,6 +91,17 @@ elseif ("${PLATFORM}" MATCHES "DRM")
     endif ()
     set(LIBS_PRIVATE ${GLESV2} ${EGL} ${DRM} ${GBM} atomic pthread m dl)
 
+elseif ("${PLATFORM}" MATCHES "Headless")
+    # No graphics device: rlgl is compiled but never initialized, no GL library is linked
+    set(PLATFORM_CPP "PLATFORM_HEADLESS")
+    set(GRAPHICS "GRAPHICS_API_OPENGL_33")
+
+    find_library(pthread NAMES pthread)
+    set(LIBS_PRIVATE m pthread)
+    if (USE_AUDIO)
+        set(LIBS_PRIVATE ${LIBS_PRIVATE} dl)
+    endif ()
+
 endif ()
 
 if (NOT ${OPENGL_VERSION} MATCHES "OFF")
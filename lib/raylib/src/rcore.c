@@ -19,6 +19,8 @@
 *           - Linux DRM subsystem (KMS mode)
 *       > PLATFORM_ANDROID:
 *           - Android (ARM, ARM64)
+*       > PLATFORM_HEADLESS:
+*           - Null platform, no window and no graphics device (CI/servers)
 *
 *   CONFIGURATION:
 *       #define SUPPORT_DEFAULT_FONT (default)
@@ -491,6 +493,8 @@ const char *TextFormat(const char *text, ...);              // Formatting of tex
     #include "platforms/rcore_drm.c"
 #elif defined(PLATFORM_ANDROID)
     #include "platforms/rcore_android.c"
+#elif defined(PLATFORM_HEADLESS)
+    #include "platforms/rcore_headless.c"
 #else
     // TODO: Include your custom platform backend!
     // i.e software rendering backend or console backend!
@@ -613,6 +617,7 @@ void InitWindow(int width, int height, const char *title)
     InitPlatform();
     //--------------------------------------------------------------
 
+#if !defined(PLATFORM_HEADLESS)
     // Initialize rlgl default data (buffers and shaders)
     // NOTE: CORE.Window.currentFbo.width and CORE.Window.currentFbo.height not used, just stored as globals in rlgl
     rlglInit(CORE.Window.currentFbo.width, CORE.Window.currentFbo.height);
@@ -656,6 +661,7 @@ void InitWindow(int width, int height, const char *title)
         rlTextureParameters(GetFontDefault().texture.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
     }
 #endif
+#endif  // !PLATFORM_HEADLESS
 
     CORE.Time.frameCounter = 0;
     CORE.Window.shouldClose = false;
@@ -676,11 +682,13 @@ void CloseWindow(void)
     }
 #endif
 
+#if !defined(PLATFORM_HEADLESS)
 #if defined(SUPPORT_MODULE_RTEXT) && defined(SUPPORT_DEFAULT_FONT)
     UnloadFontDefault();        // WARNING: Module required: rtext
 #endif
 
     rlglClose();                // De-init rlgl
+#endif
 
     // De-initialize platform
     //--------------------------------------------------------------
@@ -0,0 +1,31 @@
+#include "bezier_pattern.h"
+#include <fstream>
+#include <iostream>
+
+
+/**
+ * Compila um padrão do formato texto para o binário lido por bz::open_pattern.
+ * Uso: BezierPatternCompiler entrada.txt saida.bzp
+*/
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "uso: " << argv[0] << " entrada.txt saida.bzp" << std::endl;
+        return 1;
+    }
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "não foi possível abrir " << argv[1] << std::endl;
+        return 1;
+    }
+    bz::pattern_source_t source;
+    if (!bz::parse_pattern_text(in, &source)) {
+        return 1;
+    }
+    if (!bz::write_pattern(source, argv[2])) {
+        std::cerr << "não foi possível gravar " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << source.curves.size() << " curvas, " << source.points.size() << " pontos, "
+        << source.spawns.size() << " spawns -> " << argv[2] << std::endl;
+    return 0;
+}
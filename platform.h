@@ -0,0 +1,612 @@
+#ifndef BEZIER_PLATFORM_H
+#define BEZIER_PLATFORM_H
+#include <raylib.h>
+#include "bezier_profile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * Camada fina entre os exemplos e a janela do raylib.
+ * No modo headless nenhuma janela é criada: o tempo avança em passos fixos
+ * e a entrada vem de um roteiro (script) em vez do teclado/mouse.
+ *
+ * --record grava, frame a frame, o dt e as mudanças de entrada (e a semente
+ * do RNG, seed()) num log binário; --replay reproduz o log no lugar do
+ * teclado e do relógio. Com os mesmos argumentos de carga (--scenario,
+ * --pattern...) a simulação refaz exatamente o mesmo trabalho, e no modo
+ * headless roda tão rápido quanto a máquina permitir. O jogo pode passar um
+ * hash do estado por frame (check_state) para o replay acusar o primeiro
+ * frame que divergiu.
+*/
+namespace platform {
+
+
+    typedef struct options {
+        bool headless = false;
+        int frames = 600;          // Quantidade de frames simulados no modo headless
+        float dt = 1.0f / 60.0f;   // Passo de tempo fixo do modo headless
+        const char* script = NULL; // Arquivo com o roteiro de entrada
+        const char* trace = NULL;  // Arquivo do trace do Chrome (BZ_PROFILE)
+        const char* record = NULL; // Log de entrada a gravar
+        const char* replay = NULL; // Log de entrada a reproduzir
+        std::uint64_t seed = std::default_random_engine::default_seed;
+    } options_t;
+
+    enum TInputKind {
+        Key,
+        MouseButton,
+        MouseMove
+    };
+
+    typedef struct input_event {
+        int frame = 0;
+        TInputKind kind = TInputKind::Key;
+        int code = 0; // Tecla ou botão do mouse
+        bool down = false;
+        Vector2 position = {0.f, 0.f};
+    } input_event_t;
+
+    #define PLATFORM_MAX_KEYS 512
+    #define PLATFORM_MAX_BUTTONS 8
+
+    typedef struct input_state {
+        std::vector<input_event_t> script;
+        std::size_t cursor = 0;
+        bool keys[PLATFORM_MAX_KEYS] = {};
+        bool previous_keys[PLATFORM_MAX_KEYS] = {};
+        bool buttons[PLATFORM_MAX_BUTTONS] = {};
+        bool previous_buttons[PLATFORM_MAX_BUTTONS] = {};
+        Vector2 mouse = {0.f, 0.f};
+        Vector2 previous_mouse = {0.f, 0.f};
+    } input_state_t;
+
+    #define PLATFORM_REPLAY_MAGIC 0x4e495a42u // "BZIN"
+    #define PLATFORM_REPLAY_VERSION 1u
+
+    typedef struct replay_header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t seed;
+        std::uint32_t frames;
+        std::uint32_t events;
+    } replay_header_t;
+
+    static_assert(sizeof(replay_header_t) == 24, "layout do cabeçalho do replay mudou");
+
+    typedef struct replay_frame {
+        float dt = 0.f;
+        std::uint32_t checksum = 0;    // Hash do estado passado por check_state (0 = nenhum)
+        std::uint32_t first_event = 0; // Índice em replay_log_t::events
+        std::uint32_t event_count = 0;
+    } replay_frame_t;
+
+    #define PLATFORM_REPLAY_MIN_FRAME 9 // varint(0) + dt + checksum
+    #define PLATFORM_REPLAY_MIN_EVENT 2 // tag + varint de um código < 128
+
+    /**
+     * Log de entrada em memória (gravado inteiro no close). No arquivo um
+     * frame sem eventos ocupa 9 bytes: varint da quantidade de eventos, dt e
+     * checksum. Cada evento de tecla/botão soma 2 bytes (3 para códigos a
+     * partir de 128, como as setas) e cada movimento do mouse 9.
+    */
+    typedef struct replay_log {
+        std::uint64_t seed = 0;
+        std::vector<replay_frame_t> frames;
+        std::vector<input_event_t> events;
+    } replay_log_t;
+
+    typedef struct platform_state {
+        options_t options;
+        input_state_t input;
+        int frame = 0;
+        float dt = 0.f;
+        std::uint64_t seed = 0;
+        bool recording = false;
+        bool replaying = false;
+        replay_log_t log;
+        int diverged = -1; // Primeiro frame do replay com checksum diferente do log
+        std::chrono::steady_clock::time_point start;
+    } platform_state_t;
+
+    platform_state_t state;
+
+
+    options_t parse_args(const int argc, char const* argv[]) {
+        options_t options{};
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--headless") == 0) {
+                options.headless = true;
+            } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+                options.frames = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--dt") == 0 && i + 1 < argc) {
+                options.dt = (float) std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+                options.script = argv[++i];
+            } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+                options.trace = argv[++i];
+            } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+                options.record = argv[++i];
+            } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+                options.replay = argv[++i];
+            } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+                options.seed = std::strtoull(argv[++i], NULL, 10);
+            }
+        }
+        #if defined(PLATFORM_HEADLESS)
+            // raylib compilado sem janela: só existe o modo headless
+            options.headless = true;
+        #endif
+        return options;
+    }
+
+    int key_from_name(const std::string& name) {
+        static const struct { const char* name; int key; } keys[] = {
+            {"LEFT", KEY_LEFT}, {"RIGHT", KEY_RIGHT}, {"UP", KEY_UP}, {"DOWN", KEY_DOWN},
+            {"LEFT_SHIFT", KEY_LEFT_SHIFT}, {"SPACE", KEY_SPACE}, {"ENTER", KEY_ENTER},
+            {"ESCAPE", KEY_ESCAPE}, {"BACKSPACE", KEY_BACKSPACE}
+        };
+        for (const auto& k : keys) {
+            if (name == k.name) {
+                return k.key;
+            }
+        }
+        return name.size() == 1 ? (int) name[0] : KEY_NULL;
+    }
+
+    int button_from_name(const std::string& name) {
+        if (name == "RIGHT") return MOUSE_BUTTON_RIGHT;
+        if (name == "MIDDLE") return MOUSE_BUTTON_MIDDLE;
+        return MOUSE_BUTTON_LEFT;
+    }
+
+    /**
+     * Formato do roteiro, um evento por linha (linhas com # são ignoradas):
+     *   <frame> key <NOME> down|up
+     *   <frame> button <LEFT|RIGHT|MIDDLE> down|up
+     *   <frame> mouse <x> <y>
+    */
+    bool parse_script(std::istream& in, std::vector<input_event_t>* script) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            std::istringstream ss(line);
+            input_event_t e{};
+            std::string kind, arg;
+            if (!(ss >> e.frame >> kind)) {
+                continue;
+            }
+            if (kind == "mouse") {
+                e.kind = TInputKind::MouseMove;
+                ss >> e.position.x >> e.position.y;
+            } else {
+                std::string action;
+                ss >> arg >> action;
+                e.kind = kind == "key" ? TInputKind::Key : TInputKind::MouseButton;
+                e.code = e.kind == TInputKind::Key ? key_from_name(arg) : button_from_name(arg);
+                e.down = action == "down";
+            }
+            if (ss.fail()) {
+                std::fprintf(stderr, "platform: linha inválida no roteiro: %s\n", line.c_str());
+                return false;
+            }
+            script->push_back(e);
+        }
+        std::stable_sort(
+            script->begin(),
+            script->end(),
+            [](const input_event_t& l, const input_event_t& r) { return l.frame < r.frame; }
+        );
+        return true;
+    }
+
+    void put_varint(std::string* out, std::uint32_t v) {
+        while (v >= 0x80) {
+            out->push_back((char) (v | 0x80));
+            v >>= 7;
+        }
+        out->push_back((char) v);
+    }
+
+    bool get_varint(std::istream& in, std::uint32_t* v) {
+        *v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            const int byte = in.get();
+            if (byte == EOF) {
+                return false;
+            }
+            *v |= (std::uint32_t) (byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T>
+    void put_raw(std::string* out, const T& value) {
+        out->append((const char*) &value, sizeof(value));
+    }
+
+    template <typename T>
+    bool get_raw(std::istream& in, T* value) {
+        return (bool) in.read((char*) value, sizeof(T));
+    }
+
+    /**
+     * Por frame: varint(eventos), dt, checksum e os eventos:
+     *   byte kind | down << 2, depois varint(código) ou x, y do mouse
+    */
+    bool write_replay(const replay_log_t& log, const char* path) {
+        std::string out;
+        const replay_header_t header = {
+            PLATFORM_REPLAY_MAGIC, PLATFORM_REPLAY_VERSION, log.seed,
+            (std::uint32_t) log.frames.size(), (std::uint32_t) log.events.size()
+        };
+        put_raw(&out, header);
+        for (const replay_frame_t& frame : log.frames) {
+            put_varint(&out, frame.event_count);
+            put_raw(&out, frame.dt);
+            put_raw(&out, frame.checksum);
+            for (std::uint32_t i = 0; i < frame.event_count; i++) {
+                const input_event_t& e = log.events[frame.first_event + i];
+                out.push_back((char) (e.kind | (e.down << 2)));
+                if (e.kind == TInputKind::MouseMove) {
+                    put_raw(&out, e.position);
+                } else {
+                    put_varint(&out, (std::uint32_t) e.code);
+                }
+            }
+        }
+        std::ofstream file(path, std::ios::binary);
+        return (bool) file.write(out.data(), out.size());
+    }
+
+    bool read_replay(const char* path, replay_log_t* log) {
+        std::ifstream in(path, std::ios::binary);
+        replay_header_t header;
+        if (!get_raw(in, &header) || header.magic != PLATFORM_REPLAY_MAGIC || header.version != PLATFORM_REPLAY_VERSION) {
+            return false;
+        }
+        // Um log corrompido não pode pedir mais frames/eventos do que o arquivo comporta
+        const std::streamoff start = in.tellg();
+        in.seekg(0, std::ios::end);
+        const std::uint64_t remaining = (std::uint64_t) (in.tellg() - start);
+        in.seekg(start);
+        if ((std::uint64_t) header.frames * PLATFORM_REPLAY_MIN_FRAME > remaining ||
+            (std::uint64_t) header.events * PLATFORM_REPLAY_MIN_EVENT > remaining) {
+            return false;
+        }
+        *log = replay_log_t{};
+        log->seed = header.seed;
+        log->frames.resize(header.frames);
+        log->events.reserve(header.events);
+        for (std::uint32_t f = 0; f < header.frames; f++) {
+            replay_frame_t& frame = log->frames[f];
+            frame.first_event = log->events.size();
+            if (!get_varint(in, &frame.event_count) || !get_raw(in, &frame.dt) || !get_raw(in, &frame.checksum)) {
+                return false;
+            }
+            for (std::uint32_t i = 0; i < frame.event_count; i++) {
+                input_event_t& e = log->events.emplace_back();
+                e.frame = f;
+                const int tag = in.get();
+                if (tag == EOF || (tag & 3) > TInputKind::MouseMove) {
+                    return false;
+                }
+                e.kind = (TInputKind) (tag & 3);
+                e.down = (tag & 4) != 0;
+                std::uint32_t code = 0;
+                if (e.kind == TInputKind::MouseMove ? !get_raw(in, &e.position) : !get_varint(in, &code)) {
+                    return false;
+                }
+                e.code = (int) code;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Inicializa a plataforma. No modo headless usa o roteiro do arquivo
+     * options.script ou, se não houver, o roteiro padrão do exemplo.
+    */
+    void init(
+        const options_t& options,
+        const int width,
+        const int height,
+        const char* title,
+        const char* default_script
+    ) {
+        state = platform_state_t{};
+        state.options = options;
+        state.seed = options.seed;
+        if (options.replay != NULL) {
+            state.replaying = read_replay(options.replay, &state.log);
+            if (!state.replaying) {
+                std::fprintf(stderr, "platform: não foi possível ler o replay %s\n", options.replay);
+                std::exit(1);
+            }
+            state.seed = state.log.seed;
+        } else if (options.record != NULL) {
+            state.recording = true;
+            state.log.seed = state.seed;
+            state.log.frames.reserve(options.headless ? options.frames : 0);
+        }
+        if (options.headless && !state.replaying) {
+            bool ok = false;
+            if (options.script != NULL) {
+                std::ifstream file(options.script);
+                ok = file.is_open() && parse_script(file, &state.input.script);
+                if (!ok) {
+                    std::fprintf(stderr, "platform: não foi possível ler o roteiro %s\n", options.script);
+                }
+            }
+            if (!ok && default_script != NULL) {
+                std::istringstream in(default_script);
+                parse_script(in, &state.input.script);
+            }
+        } else if (!options.headless) {
+            SetConfigFlags(FLAG_VSYNC_HINT);
+            InitWindow(width, height, title);
+        }
+        state.start = std::chrono::steady_clock::now();
+    }
+
+    bool is_headless() {
+        return state.options.headless;
+    }
+
+    bool is_replaying() {
+        return state.replaying;
+    }
+
+    bool is_recording() {
+        return state.recording;
+    }
+
+    /**
+     * Semente do RNG da simulação (--seed, ou a gravada no replay)
+    */
+    std::uint64_t seed() {
+        return state.seed;
+    }
+
+    /**
+     * A entrada vem do estado guardado aqui (roteiro, replay ou o teclado
+     * lido uma vez por frame) em vez de direto do raylib
+    */
+    bool uses_snapshot() {
+        return state.options.headless || state.recording || state.replaying;
+    }
+
+    void write_trace() {
+        const char* path = state.options.trace != NULL ? state.options.trace : "bezier_trace.json";
+        if (bz::profile::write_chrome_trace(path)) {
+            std::printf("trace gravado em %s\n", path);
+        }
+    }
+
+    void apply_event(input_state_t* in, const input_event_t& e) {
+        switch (e.kind) {
+            case TInputKind::Key:
+                if (e.code >= 0 && e.code < PLATFORM_MAX_KEYS) in->keys[e.code] = e.down;
+                break;
+            case TInputKind::MouseButton:
+                if (e.code >= 0 && e.code < PLATFORM_MAX_BUTTONS) in->buttons[e.code] = e.down;
+                break;
+            case TInputKind::MouseMove:
+                in->mouse = e.position;
+                break;
+        }
+    }
+
+    /**
+     * Lê teclado e mouse do raylib para o estado (gravação com janela)
+    */
+    void poll_input(input_state_t* in) {
+        for (int key = 0; key < PLATFORM_MAX_KEYS; key++) {
+            in->keys[key] = IsKeyDown(key);
+        }
+        for (int button = 0; button < PLATFORM_MAX_BUTTONS; button++) {
+            in->buttons[button] = IsMouseButtonDown(button);
+        }
+        in->mouse = GetMousePosition();
+    }
+
+    /**
+     * Acrescenta ao log o dt e o que mudou desde o frame anterior
+    */
+    void record_frame(replay_log_t* log, const input_state_t& in, const float dt) {
+        replay_frame_t& frame = log->frames.emplace_back();
+        frame.dt = dt;
+        frame.first_event = log->events.size();
+        const int index = (int) log->frames.size() - 1;
+        for (int key = 0; key < PLATFORM_MAX_KEYS; key++) {
+            if (in.keys[key] != in.previous_keys[key]) {
+                log->events.push_back({index, TInputKind::Key, key, in.keys[key], {0.f, 0.f}});
+            }
+        }
+        for (int button = 0; button < PLATFORM_MAX_BUTTONS; button++) {
+            if (in.buttons[button] != in.previous_buttons[button]) {
+                log->events.push_back({index, TInputKind::MouseButton, button, in.buttons[button], {0.f, 0.f}});
+            }
+        }
+        if (std::memcmp(&in.mouse, &in.previous_mouse, sizeof(Vector2)) != 0) {
+            log->events.push_back({index, TInputKind::MouseMove, 0, false, in.mouse});
+        }
+        frame.event_count = log->events.size() - frame.first_event;
+    }
+
+    /**
+     * Aplica a entrada do frame atual: do replay, do roteiro (headless) ou do
+     * teclado. Com janela, F9 grava o trace do Chrome na hora.
+    */
+    void begin_frame() {
+        input_state_t& in = state.input;
+        std::copy(std::begin(in.keys), std::end(in.keys), std::begin(in.previous_keys));
+        std::copy(std::begin(in.buttons), std::end(in.buttons), std::begin(in.previous_buttons));
+        in.previous_mouse = in.mouse;
+        if (state.replaying) {
+            const replay_frame_t& frame = state.log.frames[state.frame];
+            for (std::uint32_t i = 0; i < frame.event_count; i++) {
+                apply_event(&in, state.log.events[frame.first_event + i]);
+            }
+            state.dt = frame.dt;
+        } else if (state.options.headless) {
+            while (in.cursor < in.script.size() && in.script[in.cursor].frame <= state.frame) {
+                apply_event(&in, in.script[in.cursor++]);
+            }
+            state.dt = state.options.dt;
+        } else {
+            if (state.recording) {
+                poll_input(&in);
+            }
+            state.dt = GetFrameTime();
+        }
+        if (!state.options.headless && IsKeyPressed(KEY_F9)) {
+            write_trace();
+        }
+        if (state.recording) {
+            record_frame(&state.log, in, state.dt);
+        }
+        state.frame++;
+    }
+
+    /**
+     * Hash do estado da simulação no fim do frame: gravado no log ou, no
+     * replay, comparado com o gravado
+    */
+    void check_state(const std::uint32_t checksum) {
+        if (state.frame == 0) {
+            return;
+        }
+        if (state.recording) {
+            state.log.frames[state.frame - 1].checksum = checksum;
+        } else if (state.replaying && state.diverged < 0) {
+            const std::uint32_t expected = state.log.frames[state.frame - 1].checksum;
+            if (expected != 0 && expected != checksum) {
+                state.diverged = state.frame - 1;
+            }
+        }
+    }
+
+    /**
+     * FNV-1a, para os checksums de check_state
+    */
+    std::uint32_t hash_bytes(std::uint32_t hash, const void* data, const std::size_t size) {
+        const unsigned char* p = (const unsigned char*) data;
+        for (std::size_t i = 0; i < size; i++) {
+            hash = (hash ^ p[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    /**
+     * O mesmo, uma palavra de 32 bits por passo (laços por bullet)
+    */
+    std::uint32_t hash_word(const std::uint32_t hash, const std::uint32_t word) {
+        return (hash ^ word) * 16777619u;
+    }
+
+    bool should_close() {
+        if (state.replaying && state.frame >= (int) state.log.frames.size()) {
+            return true;
+        }
+        if (state.options.headless) {
+            return !state.replaying && state.frame >= state.options.frames;
+        }
+        return WindowShouldClose();
+    }
+
+    float frame_time() {
+        return state.dt;
+    }
+
+    bool key_down(const int key) {
+        if (uses_snapshot()) {
+            return key >= 0 && key < PLATFORM_MAX_KEYS && state.input.keys[key];
+        }
+        return IsKeyDown(key);
+    }
+
+    bool key_pressed(const int key) {
+        if (uses_snapshot()) {
+            return key_down(key) && !state.input.previous_keys[key];
+        }
+        return IsKeyPressed(key);
+    }
+
+    bool mouse_button_pressed(const int button) {
+        if (uses_snapshot()) {
+            return button >= 0 && button < PLATFORM_MAX_BUTTONS &&
+                state.input.buttons[button] && !state.input.previous_buttons[button];
+        }
+        return IsMouseButtonPressed(button);
+    }
+
+    bool mouse_button_released(const int button) {
+        if (uses_snapshot()) {
+            return button >= 0 && button < PLATFORM_MAX_BUTTONS &&
+                !state.input.buttons[button] && state.input.previous_buttons[button];
+        }
+        return IsMouseButtonReleased(button);
+    }
+
+    Vector2 mouse_position() {
+        return uses_snapshot() ? state.input.mouse : GetMousePosition();
+    }
+
+    /**
+     * Fecha a janela ou, no modo headless, imprime o tempo total da simulação.
+     * Grava o trace se --trace foi passado.
+    */
+    void close() {
+        if (state.options.trace != NULL) {
+            write_trace();
+        }
+        if (state.recording) {
+            if (write_replay(state.log, state.options.record)) {
+                std::printf("replay: %d frames gravados em %s\n", (int) state.log.frames.size(), state.options.record);
+            } else {
+                std::fprintf(stderr, "platform: não foi possível gravar o replay %s\n", state.options.record);
+            }
+        }
+        if (state.replaying) {
+            if (state.diverged >= 0) {
+                std::printf("replay: estado divergiu do gravado no frame %d\n", state.diverged);
+            } else {
+                std::printf("replay: %d frames idênticos ao gravado\n", state.frame);
+            }
+        }
+        if (!state.options.headless) {
+            CloseWindow();
+            return;
+        }
+        const double elapsed = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - state.start
+        ).count();
+        std::printf(
+            "headless: %d frames em %.3f ms (%.4f ms/frame)\n",
+            state.frame,
+            elapsed,
+            state.frame > 0 ? elapsed / state.frame : 0.0
+        );
+    }
+
+}  // namespace platform
+
+
+
+#endif
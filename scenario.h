@@ -0,0 +1,382 @@
+#ifndef BEZIER_SCENARIO_H
+#define BEZIER_SCENARIO_H
+#include "bezier.h"
+#include "bezier_alloc.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * Cenários de estresse para o jogo: geram densidades configuráveis de bullets
+ * a partir de uma descrição com semente, e medem o tempo e as alocações de
+ * cada fase do frame (as alocações só com BZ_ALLOC_HOOKS, ver bezier_alloc.h).
+ *
+ * Descrição (pares chave=valor separados por espaço):
+ *   seed=42 bullets=100000 lifetime=4 homing=0.1 degrees=1:1,2:2,3:4 easing=Normal:3,Parabola:1
+*/
+namespace scenario {
+
+
+    typedef struct scenario {
+        unsigned int seed = 1;
+        int bullets = 1000;          // Quantidade de bullets vivos em regime
+        float lifetime = 4.f;        // time_to_complete de cada bullet
+        float homing = 0.f;          // Fração dos bullets que segue o jogador
+        std::vector<double> degrees = {0.0, 0.0, 1.0}; // Peso de cada grau (índice = grau)
+        std::vector<double> easings = {1.0};           // Peso de cada bz::TBasicFunction
+    } scenario_t;
+
+    const char* easing_names[] = {
+        "Normal", "Quadratic", "Cubic", "SquareRoot", "QuadraticEasyOut", "Parabola"
+    };
+
+    #define SCENARIO_EASING_COUNT 6
+    #define SCENARIO_MAX_DEGREE 16
+
+    /**
+     * Mais de um easing com peso: os bullets compilados compensam compor o
+     * easing na curva (bz::compile_animation)
+    */
+    bool mixes_easings(const scenario_t& desc) {
+        return std::count_if(desc.easings.begin(), desc.easings.end(), [](const double w) { return w > 0.0; }) > 1;
+    }
+
+    int easing_from_name(const std::string& name) {
+        for (int i = 0; i < SCENARIO_EASING_COUNT; i++) {
+            if (name == easing_names[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Número inteiro ou real ocupando a string inteira (sem lixo no fim e finito)
+    */
+    bool parse_long(const std::string& text, long* out) {
+        char* end = NULL;
+        errno = 0;
+        *out = std::strtol(text.c_str(), &end, 10);
+        return !text.empty() && errno == 0 && *end == '\0';
+    }
+
+    bool parse_double(const std::string& text, double* out) {
+        char* end = NULL;
+        *out = std::strtod(text.c_str(), &end);
+        return !text.empty() && *end == '\0' && std::isfinite(*out);
+    }
+
+    /**
+     * Lê uma lista "chave:peso,chave:peso" em um vetor de pesos indexado pela
+     * chave. Os pesos não podem somar 0.
+    */
+    bool parse_weights(const std::string& list, const bool easing, std::vector<double>* weights) {
+        weights->clear();
+        std::istringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            const std::size_t sep = item.find(':');
+            const std::string key = item.substr(0, sep);
+            double weight = 1.0;
+            long i = -1;
+            const bool ok = (sep == std::string::npos || parse_double(item.substr(sep + 1), &weight)) &&
+                (easing ? (i = easing_from_name(key)) >= 0 : parse_long(key, &i) && i >= 1 && i <= SCENARIO_MAX_DEGREE);
+            if (!ok || weight < 0.0) {
+                std::fprintf(stderr, "scenario: item inválido: %s\n", item.c_str());
+                return false;
+            }
+            if ((int) weights->size() <= i) {
+                weights->resize(i + 1, 0.0);
+            }
+            (*weights)[i] = weight;
+        }
+        if (std::accumulate(weights->begin(), weights->end(), 0.0) <= 0.0) {
+            std::fprintf(stderr, "scenario: pesos somam 0: %s\n", list.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool parse(const char* description, scenario_t* out) {
+        scenario_t s{};
+        std::istringstream ss(description);
+        std::string pair;
+        while (ss >> pair) {
+            const std::size_t sep = pair.find('=');
+            if (sep == std::string::npos) {
+                std::fprintf(stderr, "scenario: esperado chave=valor: %s\n", pair.c_str());
+                return false;
+            }
+            const std::string key = pair.substr(0, sep);
+            const std::string value = pair.substr(sep + 1);
+            long integer = 0;
+            double real = 0.0;
+            bool ok = true;
+            if (key == "seed") {
+                ok = parse_long(value, &integer) && integer >= 0 && integer <= UINT_MAX;
+                s.seed = (unsigned int) integer;
+            } else if (key == "bullets") {
+                ok = parse_long(value, &integer) && integer >= 0 && integer <= INT_MAX;
+                s.bullets = (int) integer;
+            } else if (key == "lifetime") {
+                ok = parse_double(value, &real);
+                s.lifetime = std::max(0.01f, (float) real);
+            } else if (key == "homing") {
+                ok = parse_double(value, &real);
+                s.homing = std::clamp((float) real, 0.f, 1.f);
+            } else if (key == "degrees") {
+                if (!parse_weights(value, false, &s.degrees)) return false;
+            } else if (key == "easing") {
+                if (!parse_weights(value, true, &s.easings)) return false;
+            } else {
+                std::fprintf(stderr, "scenario: chave desconhecida: %s\n", key.c_str());
+                return false;
+            }
+            if (!ok) {
+                std::fprintf(stderr, "scenario: valor inválido: %s\n", pair.c_str());
+                return false;
+            }
+        }
+        *out = s;
+        return true;
+    }
+
+    typedef struct spawner {
+        scenario_t desc;
+        std::mt19937 rng;
+        std::discrete_distribution<int> degree;
+        std::discrete_distribution<int> easing;
+        std::uniform_real_distribution<float> unit{0.f, 1.f};
+        double accumulator = 0.0;
+        double homing_accumulator = 0.0;
+    } spawner_t;
+
+    void init_spawner(spawner_t* spawner, const scenario_t& desc) {
+        spawner->desc = desc;
+        spawner->rng.seed(desc.seed);
+        spawner->degree = std::discrete_distribution<int>(desc.degrees.begin(), desc.degrees.end());
+        spawner->easing = std::discrete_distribution<int>(desc.easings.begin(), desc.easings.end());
+        spawner->accumulator = 0.0;
+        spawner->homing_accumulator = 0.0;
+    }
+
+    /**
+     * Quantidade de bullets a criar neste frame para manter a densidade
+     * desejada em regime (bullets / lifetime por segundo)
+    */
+    int spawn_count(spawner_t* spawner, const float dt) {
+        spawner->accumulator += spawner->desc.bullets / spawner->desc.lifetime * dt;
+        const int n = (int) spawner->accumulator;
+        spawner->accumulator -= n;
+        return n;
+    }
+
+    /**
+     * Quantos dos n bullets deste frame seguem o jogador, mantendo a fração
+     * homing ao longo dos frames mesmo quando n é pequeno
+    */
+    int homing_count(spawner_t* spawner, const int n) {
+        spawner->homing_accumulator += n * spawner->desc.homing;
+        const int k = std::min(n, (int) spawner->homing_accumulator);
+        spawner->homing_accumulator -= k;
+        return k;
+    }
+
+    /**
+     * Sorteia a curva de um bullet saindo de origin: escreve até
+     * SCENARIO_MAX_DEGREE + 1 pontos em points e retorna quantos foram escritos.
+     * Os pontos intermediários são sorteados dentro de bounds e o ponto final
+     * fica abaixo da tela, na direção de target. Duração e easing vão em state.
+    */
+    int make_curve(
+        spawner_t* spawner,
+        Vector2* points,
+        bz::animation_state_t* state,
+        const Vector2 origin,
+        const Vector2 target,
+        const Rectangle bounds
+    ) {
+        const int degree = std::clamp(spawner->degree(spawner->rng), 1, SCENARIO_MAX_DEGREE);
+        state->time_to_complete = spawner->desc.lifetime;
+        state->t_function = (bz::TBasicFunction) spawner->easing(spawner->rng);
+        points[0] = origin;
+        for (int i = 1; i < degree; i++) {
+            points[i] = {
+                bounds.x + spawner->unit(spawner->rng) * bounds.width,
+                bounds.y + spawner->unit(spawner->rng) * bounds.height
+            };
+        }
+        points[degree] = {target.x, target.y + bounds.height};
+        return degree + 1;
+    }
+
+    enum TPhase {
+        Spawn,
+        Update,
+        Cleanup,
+        Draw,
+        Snapshot,
+        PhaseCount
+    };
+
+    const char* phase_names[TPhase::PhaseCount] = {"spawn", "update", "cleanup", "draw", "snapshot"};
+
+    /**
+     * Uma amostra por fase por frame: as medições do frame são somadas e
+     * end_frame as fecha juntas, com 0 nas fases que não rodaram. Assim a
+     * linha f do CSV é sempre o frame f em todas as colunas.
+    */
+    typedef struct timings {
+        std::vector<double> samples[TPhase::PhaseCount];      // ms por frame de cada fase
+        std::vector<bz::alloc::stats_t> allocs[TPhase::PhaseCount]; // alocações por frame de cada fase
+        std::vector<int> live;                                // bullets vivos no fim do frame
+        double frame_ms[TPhase::PhaseCount] = {};             // Frame atual, até end_frame
+        bz::alloc::stats_t frame_allocs[TPhase::PhaseCount] = {};
+    } timings_t;
+
+    void reserve(timings_t* timings, const int frames) {
+        for (int p = 0; p < TPhase::PhaseCount; p++) {
+            timings->samples[p].reserve(frames);
+            timings->allocs[p].reserve(frames);
+        }
+        timings->live.reserve(frames);
+    }
+
+    /**
+     * Mede o tempo e as alocações de uma fase até o fim do escopo.
+     * Com timings NULL não faz nada.
+    */
+    typedef struct phase_timer {
+        timings_t* timings;
+        TPhase phase;
+        std::chrono::steady_clock::time_point start;
+        bz::alloc::stats_t allocs;
+        phase_timer(timings_t* timings, const TPhase phase) : timings(timings), phase(phase) {
+            if (timings != NULL) {
+                allocs = bz::alloc::snapshot();
+                start = std::chrono::steady_clock::now();
+            }
+        }
+        ~phase_timer() {
+            if (timings != NULL) {
+                const double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start
+                ).count();
+                const bz::alloc::stats_t delta = bz::alloc::snapshot() - allocs;
+                timings->frame_ms[phase] += ms;
+                timings->frame_allocs[phase] = timings->frame_allocs[phase] + delta;
+            }
+        }
+    } phase_timer_t;
+
+    /**
+     * Fecha o frame: uma amostra de cada fase e os bullets vivos
+    */
+    void end_frame(timings_t* timings, const int live) {
+        if (timings == NULL) {
+            return;
+        }
+        for (int p = 0; p < TPhase::PhaseCount; p++) {
+            timings->samples[p].push_back(timings->frame_ms[p]);
+            timings->allocs[p].push_back(timings->frame_allocs[p]);
+            timings->frame_ms[p] = 0.0;
+            timings->frame_allocs[p] = bz::alloc::stats_t{};
+        }
+        timings->live.push_back(live);
+    }
+
+    double percentile(std::vector<double> v, const double p) {
+        if (v.empty()) {
+            return 0.0;
+        }
+        const std::size_t i = std::min(v.size() - 1, (std::size_t) (p * (v.size() - 1) + 0.5));
+        std::nth_element(v.begin(), v.begin() + i, v.end());
+        return v[i];
+    }
+
+    void report(const timings_t& timings, FILE* out) {
+        double live = 0.0;
+        for (const int n : timings.live) {
+            live += n;
+        }
+        std::fprintf(
+            out, "scenario: %zu frames, %.0f bullets vivos em média\n",
+            timings.live.size(), timings.live.empty() ? 0.0 : live / timings.live.size()
+        );
+        std::fprintf(out, "%-8s %10s %10s %10s %10s", "fase", "média", "p50", "p95", "máx");
+        if (bz::alloc::available()) {
+            std::fprintf(out, " %12s %12s", "allocs/frame", "bytes/frame");
+        }
+        std::fprintf(out, "\n");
+        for (int p = 0; p < TPhase::PhaseCount; p++) {
+            const std::vector<double>& v = timings.samples[p];
+            double sum = 0.0;
+            for (const double x : v) {
+                sum += x;
+            }
+            std::fprintf(
+                out, "%-8s %10.4f %10.4f %10.4f %10.4f",
+                phase_names[p],
+                v.empty() ? 0.0 : sum / v.size(),
+                percentile(v, 0.50),
+                percentile(v, 0.95),
+                v.empty() ? 0.0 : *std::max_element(v.begin(), v.end())
+            );
+            if (bz::alloc::available()) {
+                const std::vector<bz::alloc::stats_t>& a = timings.allocs[p];
+                double allocations = 0.0, bytes = 0.0;
+                for (const bz::alloc::stats_t& x : a) {
+                    allocations += x.allocations;
+                    bytes += x.bytes;
+                }
+                std::fprintf(
+                    out, " %12.1f %12.1f",
+                    a.empty() ? 0.0 : allocations / a.size(),
+                    a.empty() ? 0.0 : bytes / a.size()
+                );
+            }
+            std::fprintf(out, "\n");
+        }
+    }
+
+    /**
+     * Grava os tempos por frame em CSV (frame, live, colunas de tempo,
+     * alocações e bytes por fase)
+    */
+    bool write_csv(const timings_t& timings, const char* path) {
+        FILE* file = std::fopen(path, "w");
+        if (file == NULL) {
+            return false;
+        }
+        std::fprintf(file, "frame,live");
+        for (int p = 0; p < TPhase::PhaseCount; p++) {
+            std::fprintf(file, ",%s_ms,%s_allocs,%s_bytes", phase_names[p], phase_names[p], phase_names[p]);
+        }
+        std::fprintf(file, "\n");
+        for (std::size_t f = 0; f < timings.live.size(); f++) {
+            std::fprintf(file, "%zu,%d", f, timings.live[f]);
+            for (int p = 0; p < TPhase::PhaseCount; p++) {
+                const bz::alloc::stats_t& x = timings.allocs[p][f];
+                std::fprintf(file, ",%.6f,%zu,%zu", timings.samples[p][f], x.allocations, x.bytes);
+            }
+            std::fprintf(file, "\n");
+        }
+        std::fclose(file);
+        return true;
+    }
+
+}  // namespace scenario
+
+
+
+#endif
@@ -0,0 +1,84 @@
+#include "bezier_trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+
+#define TRACE_TOOL_CELL 64     // Lado da célula da grade de densidade, em pixels
+#define TRACE_TOOL_HOTSPOTS 5
+
+
+/**
+ * Resumo de um trace gravado com --bullet-trace: ticks, bullets, tamanho,
+ * tempo de vida dos bullets e as células da tela com mais bullets.
+ * Uso: BezierTraceTool trace.bzt
+*/
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "uso: " << argv[0] << " trace.bzt" << std::endl;
+        return 1;
+    }
+    bz::trace_view_t view;
+    if (!bz::open_trace_view(argv[1], &view)) {
+        std::cerr << "não foi possível abrir " << argv[1] << std::endl;
+        return 1;
+    }
+    bz::trace_tick_t tick;
+    std::uint64_t ticks = 0;
+    std::uint64_t bullets = 0;
+    std::uint32_t peak = 0;
+    std::uint32_t peak_tick = 0;
+    std::unordered_map<std::uint32_t, std::uint32_t> lifetimes; // id -> ticks vivo
+    std::unordered_map<std::uint64_t, std::uint64_t> cells;     // (cx, cy) -> bullets
+    while (bz::next_tick(&view, &tick)) {
+        ticks++;
+        bullets += tick.ids.size();
+        if (tick.ids.size() > peak) {
+            peak = tick.ids.size();
+            peak_tick = tick.tick;
+        }
+        for (std::size_t i = 0; i < tick.ids.size(); i++) {
+            lifetimes[tick.ids[i]]++;
+            const std::uint32_t cx = (std::uint32_t) (std::int32_t) std::floor(tick.positions[i].x / TRACE_TOOL_CELL);
+            const std::uint32_t cy = (std::uint32_t) (std::int32_t) std::floor(tick.positions[i].y / TRACE_TOOL_CELL);
+            cells[((std::uint64_t) cx << 32) | cy]++;
+        }
+    }
+    if (view.failed) {
+        std::cerr << "trace truncado ou corrompido depois do tick " << tick.tick << std::endl;
+    }
+    std::uint64_t lived = 0;
+    std::uint32_t longest = 0;
+    for (const auto& [id, life] : lifetimes) {
+        lived += life;
+        longest = std::max(longest, life);
+    }
+    std::printf("%s: %zu bytes\n", argv[1], view.size);
+    std::printf("  ticks: %llu\n", (unsigned long long) ticks);
+    std::printf("  bullets: %llu (pico de %u no tick %u)\n", (unsigned long long) bullets, peak, peak_tick);
+    std::printf("  bytes/bullet: %.2f\n", bullets > 0 ? (double) view.size / bullets : 0.0);
+    std::printf(
+        "  ids: %zu, vida média %.1f ticks, máxima %u\n",
+        lifetimes.size(), lifetimes.empty() ? 0.0 : (double) lived / lifetimes.size(), longest
+    );
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> hotspots(cells.begin(), cells.end());
+    const std::size_t shown = std::min<std::size_t>(TRACE_TOOL_HOTSPOTS, hotspots.size());
+    std::partial_sort(
+        hotspots.begin(), hotspots.begin() + shown, hotspots.end(),
+        [](const auto& l, const auto& r) { return l.second > r.second; }
+    );
+    std::printf("  células %dx%d mais densas (bullets por tick):\n", TRACE_TOOL_CELL, TRACE_TOOL_CELL);
+    for (std::size_t i = 0; i < shown; i++) {
+        const int cx = (std::int32_t) (std::uint32_t) (hotspots[i].first >> 32);
+        const int cy = (std::int32_t) (std::uint32_t) hotspots[i].first;
+        std::printf(
+            "    (%d, %d): %.2f\n",
+            cx * TRACE_TOOL_CELL, cy * TRACE_TOOL_CELL, ticks > 0 ? (double) hotspots[i].second / ticks : 0.0
+        );
+    }
+    const bool failed = view.failed;
+    bz::close_trace_view(&view);
+    return failed ? 1 : 0;
+}